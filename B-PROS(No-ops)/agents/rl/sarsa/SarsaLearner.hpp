@@ -13,6 +13,10 @@
 #define RLLEARNER_H
 #include "../RLLearner.hpp"
 #endif
+#ifndef PAGED_WEIGHT_TABLE_H
+#define PAGED_WEIGHT_TABLE_H
+#include "../../../common/PagedWeightTable.hpp"
+#endif
 #include <vector>
 using namespace std;
 
@@ -21,6 +25,7 @@ class SarsaLearner : public RLLearner{
 		float alpha, delta, lambda, traceThreshold;
 		int numFeatures, currentAction, nextAction;
 		int toSaveWeightsAfterLearning, saveWeightsEveryXFrames, toSaveCheckPoint;
+		int compressionLevel;				//zlib level of the check points and weights files, 0 to not compress them
 
 		std::string nameWeightsFile, pathWeightsFileToLoad;
         std::string checkPointName;
@@ -34,8 +39,8 @@ class SarsaLearner : public RLLearner{
 		vector<int> Fnext;              //Set of features active in next state
 		vector<float> Q;               //Q(a) entries
 		vector<float> Qnext;           //Q(a) entries for next action
-		vector<vector<float> > e;      //Eligibility trace
-		vector<vector<float> > w;      //Theta, weights vector
+		PagedWeightTable e;            //Eligibility trace, pages allocated as features are seen
+		PagedWeightTable w;            //Theta, weights vector, pages allocated as features are seen
 		vector<vector<int> >nonZeroElig;//To optimize the implementation
         vector<vector<int> > featureSeen;
     
@@ -82,7 +87,7 @@ class SarsaLearner : public RLLearner{
         */
         void loadWeights();
         void saveCheckPoint(int episode, int totalNumberFrames,  vector<float>& episodeResults, int& frequency, vector<int>& episodeFrames, vector<double>& episodeFps);
-        void loadCheckPoint(ifstream& checkPointToLoad);
+        void loadCheckPoint(std::istream& checkPointToLoad);
     public:
 		SarsaLearner(ALEInterface& ale, Features *features, Parameters *param,int seed);
 		/**
@@ -0,0 +1,104 @@
+/****************************************************************************************
+ ** Storage for one float per (action, feature), used by SarsaLearner for the weights and
+ ** the eligibility traces. B-PROS has millions of features but only a small fraction of them
+ ** is ever active, so instead of one dense vector<float>(numFeatures) per action the values
+ ** are split in pages of PAGE_SIZE consecutive features. A page is only allocated the first
+ ** time one of its values is written, before that it points to a shared page of zeros.
+ **
+ ** REMARKS: - get() never allocates and has no branch: it is the directory lookup plus the
+ **            load, so it is used to read, e.g. to compute the Q-values.
+ **          - operator() returns a reference that can be written, allocating the page if
+ **            it is still the zero page.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#include <stdlib.h>
+#include <vector>
+
+class PagedWeightTable{
+private:
+    std::vector<float*> pages;      //pagesPerAction entries per action
+    int numActions;
+    long long numFeatures;
+    long long pagesPerAction;
+    long long numAllocatedPages;
+
+    static float* getZeroPage(){
+        static float zeroPage[PAGE_SIZE] = {};
+        return zeroPage;
+    }
+
+    void freePages(){
+        for (size_t p = 0; p < pages.size(); p++){
+            if (pages[p] != getZeroPage()){
+                free(pages[p]);
+            }
+        }
+        pages.clear();
+        numAllocatedPages = 0;
+    }
+
+    PagedWeightTable(const PagedWeightTable&);
+    PagedWeightTable& operator=(const PagedWeightTable&);
+
+public:
+    static const int PAGE_BITS = 10;
+    static const long long PAGE_SIZE = 1 << PAGE_BITS;     //4KB of floats
+
+    PagedWeightTable(){
+        numActions = 0;
+        numFeatures = 0;
+        pagesPerAction = 0;
+        numAllocatedPages = 0;
+    }
+    ~PagedWeightTable(){
+        freePages();
+    }
+    /**
+     * Sets the number of actions and features, all values are 0 and no page is allocated.
+     */
+    void init(int numActions, long long numFeatures){
+        freePages();
+        this->numActions = numActions;
+        this->numFeatures = numFeatures;
+        pagesPerAction = (numFeatures + PAGE_SIZE - 1) / PAGE_SIZE;
+        pages.assign(numActions * pagesPerAction, getZeroPage());
+    }
+    float get(int action, long long feature) const{
+        return pages[action * pagesPerAction + (feature >> PAGE_BITS)][feature & (PAGE_SIZE - 1)];
+    }
+    float& operator()(int action, long long feature){
+        float*& page = pages[action * pagesPerAction + (feature >> PAGE_BITS)];
+        if (page == getZeroPage()){
+            page = (float*) calloc(PAGE_SIZE, sizeof(float));
+            if (page == NULL){
+                abort();
+            }
+            numAllocatedPages++;
+        }
+        return page[feature & (PAGE_SIZE - 1)];
+    }
+    /**
+     * Pages that were never written only have zeros, they can be skipped when iterating,
+     * e.g. to save the non-zero weights.
+     */
+    bool isPageAllocated(int action, long long page) const{
+        return pages[action * pagesPerAction + page] != getZeroPage();
+    }
+    int getNumActions() const{
+        return numActions;
+    }
+    long long getNumFeatures() const{
+        return numFeatures;
+    }
+    long long getPagesPerAction() const{
+        return pagesPerAction;
+    }
+    /**
+     * @return long long memory used by the allocated pages, in bytes
+     */
+    long long getAllocatedBytes() const{
+        return numAllocatedPages * PAGE_SIZE * (long long) sizeof(float);
+    }
+};
@@ -208,6 +208,24 @@ void Parameters::parseParametersFromConfigFile(std::string cfgFileName){
     }else{
         this->setNoOpMax(0);
     }
+    
+    if (parameters.count("BPRO_GENERATOR")>0){
+        this->setBproGenerator(atoi(parameters["BPRO_GENERATOR"].c_str()));
+    }else{
+        this->setBproGenerator(0);
+    }
+    
+    if (parameters.count("INCREMENTAL_FEATURES")>0){
+        this->setIncrementalFeatures(atoi(parameters["INCREMENTAL_FEATURES"].c_str()));
+    }else{
+        this->setIncrementalFeatures(0);
+    }
+    
+    if (parameters.count("COMPRESSION_LEVEL")>0){
+        this->setCompressionLevel(atoi(parameters["COMPRESSION_LEVEL"].c_str()));
+    }else{
+        this->setCompressionLevel(0);
+    }
 }
 
 void Parameters::setSaveTrajectoryPath(std::string name){
@@ -476,4 +494,28 @@ int Parameters::getRandomNoOp(){
 
 int Parameters::getNoOpMax(){
     return this->noOpMax;
+}
+
+void Parameters::setBproGenerator(int a){
+    this->bproGenerator = a;
+}
+
+int Parameters::getBproGenerator(){
+    return this->bproGenerator;
+}
+
+void Parameters::setIncrementalFeatures(int a){
+    this->incrementalFeatures = a;
+}
+
+int Parameters::getIncrementalFeatures(){
+    return this->incrementalFeatures;
+}
+
+void Parameters::setCompressionLevel(int a){
+    this->compressionLevel = a;
+}
+
+int Parameters::getCompressionLevel(){
+    return this->compressionLevel;
 }
\ No newline at end of file
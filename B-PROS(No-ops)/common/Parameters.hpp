@@ -53,6 +53,9 @@ class Parameters{
 		int learningLength;             //The number of frames to be learned, in total. DQN uses, for example, 50,000,000.
         int randomNoOp;
         int noOpMax;
+        int bproGenerator;          //0: enumerate all pairs of tiles, 1: correlate per-color occupancy bitmasks
+        int incrementalFeatures;    //whether tiles and pairwise offsets are updated only where the screen changed
+        int compressionLevel;       //zlib level of the check points and weights files written, 0 to write them uncompressed
     std::mt19937 agentRand;
     
 	   /**
@@ -222,6 +225,9 @@ class Parameters{
         void setCheckPointName(std::string fileName);
         void setRandomNoOp(int a);
         void setNoOpMax(int a);
+        void setBproGenerator(int a);
+        void setIncrementalFeatures(int a);
+        void setCompressionLevel(int a);
 		
 	public:
 		/**
@@ -359,4 +365,7 @@ class Parameters{
         std::mt19937* getRNG();
         int getRandomNoOp();
         int getNoOpMax();
+        int getBproGenerator();
+        int getIncrementalFeatures();
+        int getCompressionLevel();
 };
@@ -19,6 +19,11 @@
 
 #include <set>
 #include <assert.h>
+#include <algorithm>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 using namespace std;
 //#include <tuple>
 //#include <boost/tuple/tuple.hpp> //TODO: I have to remove this to not have to depend on boost
@@ -38,59 +43,242 @@ BPROFeatures::BPROFeatures(Parameters *param){
     numBasicFeatures = this->param->getNumColumns() * this->param->getNumRows() * this->param->getNumColors();
 	numRelativeFeatures = (2 * this->param->getNumColumns() - 1) * (2 * this->param->getNumRows() - 1) 
 							* (1+this->param->getNumColors()) * this->param->getNumColors()/2;
-    changed.clear();
-    bproExistence.resize(2*numRows-1);
-    for (int i=0;i<2*numRows-1;i++){
-        bproExistence[i].resize(2*numColumns-1);
-        for (int j=0;j<2*numColumns-1;j++){
-            bproExistence[i][j]=true;
-        }
+    //The color-presence masks have 128 bits, enough for both SECAM and NTSC
+    assert(numColors <= 128);
+    int screenWidth = 160;
+    int blockWidth = screenWidth / numColumns;
+    //Columns that do not fit in a whole tile go to an extra tile that is never read
+    tileColors.resize(numRows*(numColumns+1)*2, 0);
+    columnToTile.resize(screenWidth);
+    for (int x=0;x<screenWidth;x++){
+        columnToTile[x] = min(x/blockWidth,numColumns);
+    }
+    
+    if(this->param->getBproGenerator() == 1){
+        //Column offsets are shifted into a 64-bit word, up to 2*32-1 of them
+        assert(numColumns <= 32);
+        colorOccupancy.resize(numColors*numRows, 0);
+        offsetRows.resize(2*numRows-1, 0);
+    }
+    if(this->param->getIncrementalFeatures()){
+        //The column offsets of a color pair are kept in a 64-bit word, and the dirty tiles of a row in 32 bits
+        assert(numColumns <= 32);
+        colorOccupancy.resize(numColors*numRows, 0);
+        pairOffsetCounts.resize(numRelativeFeatures, 0);
+        pairOffsetRows.resize((1+numColors)*numColors/2*(2*numRows-1), 0);
+        colorTileCount.resize(numColors, 0);
     }
+    presentColors[0] = presentColors[1] = 0;
+    
+    bproStamps.resize((2*numRows-1)*(2*numColumns-1));
 }
 
 BPROFeatures::~BPROFeatures(){}
 
-int BPROFeatures::getBasicFeaturesIndices(const ALEScreen &screen, int blockWidth, int blockHeight, 
+//Quantizes a whole row of the screen, writing 0xFF where the pixel is equal to the background.
+//Since the quantized colors are always smaller than 128, 0xFF never sets a bit in the color masks.
+void BPROFeatures::quantizeRow(const unsigned char* row, const unsigned char* backgroundRow, unsigned char* quantized, int width){
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i lowBits = _mm_set1_epi8((char)(numColors == 8 ? 0x0F : 0xFF));
+    const __m128i colorBits = _mm_set1_epi8(numColors == 8 ? 0x07 : 0x7F);
+    for (; x + 16 <= width; x += 16){
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(row + x));
+        __m128i colors = pixels;
+        if(numColors == 8 || numColors == 128){
+            //There is no byte shift in SSE2, the bit shifted in from the neighbor byte is masked out
+            colors = _mm_and_si128(_mm_srli_epi16(_mm_and_si128(pixels, lowBits), 1), colorBits);
+        }
+        if(backgroundRow != NULL){
+            colors = _mm_or_si128(colors, _mm_cmpeq_epi8(pixels, _mm_loadu_si128((const __m128i*)(backgroundRow + x))));
+        }
+        _mm_storeu_si128((__m128i*)(quantized + x), colors);
+    }
+#endif
+    for (; x < width; x++){
+        unsigned char pixel = row[x];
+        if(backgroundRow != NULL && backgroundRow[x] == pixel){
+            quantized[x] = 0xFF;
+            continue;
+        }
+        if(numColors == 8){ //SECAM, considering only 8 colors
+            pixel = (pixel & 0xF) >> 1;
+        }
+        else if(numColors == 128){ //NTSC, considering 128 colors
+            pixel = pixel >> 1;
+        }
+        quantized[x] = pixel;
+    }
+}
+
+//Compares the screen with the previous one and recomputes the color-presence masks only of
+//the tiles with a changed pixel. Every color a tile gains or loses updates the pair counts.
+void BPROFeatures::updateDirtyTiles(const ALEScreen &screen, int blockWidth, int blockHeight){
+    int screenWidth = 160;
+    int tilesPerRow = numColumns+1;
+    unsigned char quantized[160];
+    unsigned long long newColors[64];
+    bool firstScreen = previousScreen.empty();
+    if(firstScreen){
+        previousScreen.resize(numRows*blockHeight*screenWidth);
+    }
+    
+    for (int by = 0; by < numRows; by++){
+        unsigned int dirtyTiles = 0;
+        if(firstScreen){
+            dirtyTiles = numColumns == 32 ? ~0u : (1u << numColumns) - 1;
+        }
+        for (int y = by*blockHeight; y < (by+1)*blockHeight; y++){
+            const unsigned char* row = screen.getRow(y);
+            unsigned char* previousRow = &previousScreen[y*screenWidth];
+            if(memcmp(row, previousRow, screenWidth) != 0){
+                for (int bx = 0; bx < numColumns; bx++){
+                    if(!(dirtyTiles & (1u << bx)) && memcmp(row+bx*blockWidth, previousRow+bx*blockWidth, blockWidth) != 0){
+                        dirtyTiles |= 1u << bx;
+                    }
+                }
+                memcpy(previousRow, row, screenWidth);
+            }
+        }
+        if(dirtyTiles == 0){
+            continue;
+        }
+        
+        memset(newColors, 0, sizeof(newColors));
+        for (int y = by*blockHeight; y < (by+1)*blockHeight; y++){
+            const unsigned char* backgroundRow = NULL;
+            if(this->param->getSubtractBackground()){
+                backgroundRow = this->background->getRow(y);
+            }
+            quantizeRow(screen.getRow(y), backgroundRow, quantized, screenWidth);
+            for (unsigned int tiles = dirtyTiles; tiles; tiles &= tiles - 1){
+                int bx = __builtin_ctz(tiles);
+                for (int x = bx*blockWidth; x < (bx+1)*blockWidth; x++){
+                    unsigned char color = quantized[x];
+                    newColors[bx*2 + ((color >> 6) & 1)] |= (unsigned long long)(color < 128) << (color & 63);
+                }
+            }
+        }
+        
+        for (unsigned int tiles = dirtyTiles; tiles; tiles &= tiles - 1){
+            int bx = __builtin_ctz(tiles);
+            for (int word = 0; word < 2; word++){
+                unsigned long long& oldColors = tileColors[(by * tilesPerRow + bx) * 2 + word];
+                for (unsigned long long removed = oldColors & ~newColors[bx*2+word]; removed; removed &= removed - 1){
+                    updatePairOffsetCounts(by, bx, word * 64 + __builtin_ctzll(removed), -1);
+                }
+                for (unsigned long long added = newColors[bx*2+word] & ~oldColors; added; added &= added - 1){
+                    updatePairOffsetCounts(by, bx, word * 64 + __builtin_ctzll(added), 1);
+                }
+                oldColors = newColors[bx*2+word];
+            }
+        }
+    }
+}
+
+//Adds (delta=1) or removes (delta=-1) the tile (row, column) of the given color, updating the
+//number of pairs of tiles at each offset between this tile and all the tiles currently present.
+//Pairs of the same color are counted once, at the offset that is emitted as a feature.
+void BPROFeatures::updatePairOffsetCounts(int row, int column, int color, int delta){
+    int numRowOffsets = 2*numRows - 1;
+    int numColumnOffsets = 2*numColumns - 1;
+    if(delta > 0){
+        colorOccupancy[color*numRows+row] |= 1u << column;
+        if(colorTileCount[color]++ == 0){
+            presentColors[color >> 6] |= 1ULL << (color & 63);
+        }
+    }
+    
+    for (int word = 0; word < 2; word++){
+        for (unsigned long long colors = presentColors[word]; colors; colors &= colors - 1){
+            int other = word * 64 + __builtin_ctzll(colors);
+            int c1 = min(color, other);
+            int c2 = max(color, other);
+            int pair = (numColors+numColors-c1+1)*c1/2+(c2-c1);
+            for (int otherRow = 0; otherRow < numRows; otherRow++){
+                for (unsigned int tiles = colorOccupancy[other*numRows+otherRow]; tiles; tiles &= tiles - 1){
+                    int otherColumn = __builtin_ctz(tiles);
+                    int rowDelta = row - otherRow;
+                    int columnDelta = column - otherColumn;
+                    if(color > other || (color == other && (rowDelta < 0 || (rowDelta == 0 && columnDelta < 0)))){
+                        rowDelta = -rowDelta;
+                        columnDelta = -columnDelta;
+                    }
+                    rowDelta += numRows-1;
+                    columnDelta += numColumns-1;
+                    unsigned short& count = pairOffsetCounts[(int)pair*numRowOffsets*numColumnOffsets+rowDelta*numColumnOffsets+columnDelta];
+                    count += delta;
+                    if(count == 0){
+                        pairOffsetRows[pair*numRowOffsets+rowDelta] &= ~(1ULL << columnDelta);
+                    }else if(count == 1 && delta > 0){
+                        pairOffsetRows[pair*numRowOffsets+rowDelta] |= 1ULL << columnDelta;
+                    }
+                }
+            }
+        }
+    }
+    
+    if(delta < 0){
+        colorOccupancy[color*numRows+row] &= ~(1u << column);
+        if(--colorTileCount[color] == 0){
+            presentColors[color >> 6] &= ~(1ULL << (color & 63));
+        }
+    }
+}
+
+int BPROFeatures::getBasicFeaturesIndices(const ALEScreen &screen, int blockWidth, int blockHeight,
                                           vector<vector<tuple<int,int> > > &whichColors, vector<int>& features){
+    int screenWidth = 160;
+    int tilesPerRow = numColumns+1;
+    unsigned char quantized[160];
+    if(this->param->getIncrementalFeatures()){
+        updateDirtyTiles(screen, blockWidth, blockHeight);
+    }else{
+        fill(tileColors.begin(), tileColors.end(), 0);
+        
+        // Build the color-presence mask of every tile, one screen row at a time
+        for (int y = 0; y < numRows * blockHeight; y++){
+            const unsigned char* backgroundRow = NULL;
+            if(this->param->getSubtractBackground()){
+                backgroundRow = this->background->getRow(y);
+            }
+            quantizeRow(screen.getRow(y), backgroundRow, quantized, screenWidth);
+            unsigned long long* rowMasks = &tileColors[(y / blockHeight) * tilesPerRow * 2];
+            for (int x = 0; x < screenWidth; x++){
+                unsigned char color = quantized[x];
+                rowMasks[columnToTile[x]*2 + ((color >> 6) & 1)] |= (unsigned long long)(color < 128) << (color & 63);
+            }
+        }
+    }
+    
+    // Emit the (tile, color) indices in the same order as iterating over all colors of each tile
 	int featureIndex = 0;
-	// For each pixel block
+    unsigned long long frameColors[2] = {0, 0};
 	for (int by = 0; by < numRows; by++) {
 		for (int bx = 0; bx < numColumns; bx++) {
-			//vector<boost::tuple<int, int, int> > posAndColor;
-			
-			int xo = bx * blockWidth;
-			int yo = by * blockHeight;
-			vector<bool> hasColor(numColors, false);
-			
-			// Determine which colors are present
-			for (int x = xo; x < xo + blockWidth; x++){
-				for (int y = yo; y < yo + blockHeight; y++){
-					unsigned char pixel = screen.get(y,x);
-
-					if(!this->param->getSubtractBackground() || (this->background->getPixel(y, x) != pixel)){
-						if(numColors == 8){ //SECAM, considering only 8 colors
-							pixel = (pixel & 0xF) >> 1;
-						}
-						else if(numColors == 128){ //NTSC, considering 128 colors
-							pixel = pixel >> 1;
-						}
-		  				
-		  				hasColor[pixel] = true;
-						//posAndColor.push_back(boost::make_tuple(x, y, pixel));
-					}
-				}
-			}
-
-			for(int c = 0; c < numColors; c++){
-				if(hasColor[c]){
+            for (int word = 0; word < 2; word++){
+                unsigned long long mask = tileColors[(by * tilesPerRow + bx) * 2 + word];
+                frameColors[word] |= mask;
+                while (mask){
+                    int c = word * 64 + __builtin_ctzll(mask);
                     tuple<int,int> pos (by,bx);
-					whichColors[c].push_back(pos);
-					features.push_back(featureIndex);
-				}
-				featureIndex++;
-			}
+                    whichColors[c].push_back(pos);
+                    features.push_back(featureIndex + c);
+                    mask &= mask - 1;
+                }
+            }
+            featureIndex += numColors;
 		}
 	}
+    
+    // Colors present anywhere in the frame, in increasing order, so the pair loops skip the empty ones
+    activeColors.clear();
+    for (int word = 0; word < 2; word++){
+        while (frameColors[word]){
+            activeColors.push_back(word * 64 + __builtin_ctzll(frameColors[word]));
+            frameColors[word] &= frameColors[word] - 1;
+        }
+    }
 	return featureIndex;
 }
 
@@ -102,7 +290,8 @@ void BPROFeatures::addRelativeFeaturesIndices(const ALEScreen &screen, int featu
 	int numOffsets = numRowOffsets*numColumnOffsets;
 	int numColorPairs = (1+numColors)*numColors/2;
     
-    for (int c1=0;c1<numColors;c1++){
+    for (int i=0;i<activeColors.size();i++){
+        int c1 = activeColors[i];
         for (int k=0;k<whichColors[c1].size();k++){
             for (int h=0;h<whichColors[c1].size();h++){
                 int rowDelta = get<0>(whichColors[c1][k])-get<0>(whichColors[c1][h]);
@@ -115,37 +304,111 @@ void BPROFeatures::addRelativeFeaturesIndices(const ALEScreen &screen, int featu
                 }
                 rowDelta+=numRows-1;
                 columnDelta+=numColumns-1;
-                if (newBproFeature && bproExistence[rowDelta][columnDelta]){
-                    tuple<int,int> pos (rowDelta,columnDelta);
-                    changed.push_back(pos);
-                    bproExistence[rowDelta][columnDelta]=false;
+                if (newBproFeature && bproStamps.insert(rowDelta*numColumnOffsets+columnDelta)){
                     features.push_back(numBasicFeatures+(numColors+numColors-c1+1)*c1/2*numRowOffsets*numColumnOffsets+rowDelta*numColumnOffsets+columnDelta);
                     
                 }
             }
         }
-        resetBproExistence(bproExistence,changed);
-
-        for (int c2=c1+1;c2<numColors;c2++){
-            if (whichColors[c1].size()>0 && whichColors[c2].size()>0){
-                for (vector<tuple<int,int> >::iterator it1=whichColors[c1].begin();it1!=whichColors[c1].end();it1++){
-                    for (vector<tuple<int,int> >::iterator it2=whichColors[c2].begin();it2!=whichColors[c2].end();it2++){
-                        int rowDelta = get<0>(*it1)-get<0>(*it2)+numRows-1;
-                        int columnDelta = get<1>(*it1)-get<1>(*it2)+numColumns-1;
-                        if (bproExistence[rowDelta][columnDelta]){
-                            tuple<int,int> pos(rowDelta,columnDelta);
-                            changed.push_back(pos);
-                            bproExistence[rowDelta][columnDelta]=false;
-                            features.push_back(numBasicFeatures+(numColors+numColors-c1+1)*c1/2*numRowOffsets*numColumnOffsets+(c2-c1)*numRowOffsets*numColumnOffsets+rowDelta*numColumnOffsets+columnDelta);
-                        }
+        bproStamps.clear();
+
+        for (int j=i+1;j<activeColors.size();j++){
+            int c2 = activeColors[j];
+            for (vector<tuple<int,int> >::iterator it1=whichColors[c1].begin();it1!=whichColors[c1].end();it1++){
+                for (vector<tuple<int,int> >::iterator it2=whichColors[c2].begin();it2!=whichColors[c2].end();it2++){
+                    int rowDelta = get<0>(*it1)-get<0>(*it2)+numRows-1;
+                    int columnDelta = get<1>(*it1)-get<1>(*it2)+numColumns-1;
+                    if (bproStamps.insert(rowDelta*numColumnOffsets+columnDelta)){
+                        features.push_back(numBasicFeatures+(numColors+numColors-c1+1)*c1/2*numRowOffsets*numColumnOffsets+(c2-c1)*numRowOffsets*numColumnOffsets+rowDelta*numColumnOffsets+columnDelta);
                     }
                 }
             }
-            resetBproExistence(bproExistence,changed);
+            bproStamps.clear();
         }
     }    
 }
 
+//Same features as addRelativeFeaturesIndices, but instead of enumerating every pair of tiles
+//the occupancy rows of the first color are shifted by the column of each tile of the second
+//color, so a single OR marks all the column offsets between that tile and a whole row.
+//The indices of a color pair are emitted in increasing order.
+void BPROFeatures::addRelativeFeaturesIndicesFromMasks(vector<vector<tuple<int,int> > > &whichColors, vector<int>& features){
+
+	int numRowOffsets = 2*numRows - 1;
+	int numColumnOffsets = 2*numColumns - 1;
+	int numOffsets = numRowOffsets*numColumnOffsets;
+    
+    for (int i=0;i<activeColors.size();i++){
+        int c = activeColors[i];
+        for (vector<tuple<int,int> >::iterator it=whichColors[c].begin();it!=whichColors[c].end();it++){
+            colorOccupancy[c*numRows+get<0>(*it)] |= 1u << get<1>(*it);
+        }
+    }
+    
+    for (int i=0;i<activeColors.size();i++){
+        int c1 = activeColors[i];
+        unsigned int* occupancy1 = &colorOccupancy[c1*numRows];
+        //whichColors is filled in raster order, so the first and last tiles bound the rows
+        int firstRow1 = get<0>(whichColors[c1].front());
+        int lastRow1 = get<0>(whichColors[c1].back());
+        for (int j=i;j<activeColors.size();j++){
+            int c2 = activeColors[j];
+            for (vector<tuple<int,int> >::iterator it=whichColors[c2].begin();it!=whichColors[c2].end();it++){
+                int row2 = get<0>(*it);
+                int column2 = get<1>(*it);
+                for (int row1=firstRow1;row1<=lastRow1;row1++){
+                    //Bit (column1-column2+numColumns-1) is set for every tile of c1 in row1
+                    offsetRows[row1-row2+numRows-1] |= ((unsigned long long)occupancy1[row1] << (numColumns-1)) >> column2;
+                }
+            }
+            
+            int pairIndex = numBasicFeatures+(numColors+numColors-c1+1)*c1/2*numOffsets+(c2-c1)*numOffsets;
+            //For a single color only half of the offsets are features, the other half is its mirror
+            int firstRowDelta = 0;
+            if (c1==c2){
+                firstRowDelta = numRows-1;
+                offsetRows[firstRowDelta] &= ~0ULL << (numColumns-1);
+            }
+            for (int rowDelta=firstRowDelta;rowDelta<numRowOffsets;rowDelta++){
+                unsigned long long offsets = offsetRows[rowDelta];
+                while (offsets){
+                    features.push_back(pairIndex+rowDelta*numColumnOffsets+__builtin_ctzll(offsets));
+                    offsets &= offsets - 1;
+                }
+            }
+            fill(offsetRows.begin(), offsetRows.end(), 0);
+        }
+    }
+    
+    for (int i=0;i<activeColors.size();i++){
+        fill(colorOccupancy.begin()+activeColors[i]*numRows, colorOccupancy.begin()+(activeColors[i]+1)*numRows, 0);
+    }
+}
+
+//Emits the offsets with a nonzero count of every pair of colors present in the frame, the same
+//features addRelativeFeaturesIndices finds from scratch. Within a color pair they are in increasing order.
+void BPROFeatures::addRelativeFeaturesIndicesFromCounts(vector<int>& features){
+    int numRowOffsets = 2*numRows - 1;
+    int numColumnOffsets = 2*numColumns - 1;
+    int numOffsets = numRowOffsets*numColumnOffsets;
+    
+    for (int i=0;i<activeColors.size();i++){
+        int c1 = activeColors[i];
+        for (int j=i;j<activeColors.size();j++){
+            int c2 = activeColors[j];
+            int pair = (numColors+numColors-c1+1)*c1/2+(c2-c1);
+            int pairIndex = numBasicFeatures+(int)pair*numOffsets;
+            for (int rowDelta=0;rowDelta<numRowOffsets;rowDelta++){
+                unsigned long long offsets = pairOffsetRows[pair*numRowOffsets+rowDelta];
+                while (offsets){
+                    features.push_back(pairIndex+rowDelta*numColumnOffsets+__builtin_ctzll(offsets));
+                    offsets &= offsets - 1;
+                }
+            }
+        }
+    }
+}
+
 void BPROFeatures::getActiveFeaturesIndices(const ALEScreen &screen, const ALERAM &ram, vector<int>& features){
 	int screenWidth = screen.width();
 	int screenHeight = screen.height();
@@ -164,7 +427,13 @@ void BPROFeatures::getActiveFeaturesIndices(const ALEScreen &screen, const ALERA
     //We first get the Basic features, keeping track of the next featureIndex vector:
     //We don't just use the Basic implementation because we need the whichColors information
 	int featureIndex = getBasicFeaturesIndices(screen, blockWidth, blockHeight, whichColors, features);
-	addRelativeFeaturesIndices(screen, featureIndex, whichColors, features);
+    if(this->param->getIncrementalFeatures()){
+        addRelativeFeaturesIndicesFromCounts(features);
+    }else if(this->param->getBproGenerator() == 1){
+        addRelativeFeaturesIndicesFromMasks(whichColors, features);
+    }else{
+        addRelativeFeaturesIndices(screen, featureIndex, whichColors, features);
+    }
 
 	//Bias
 	features.push_back(numBasicFeatures+numRelativeFeatures);
@@ -172,11 +441,4 @@ void BPROFeatures::getActiveFeaturesIndices(const ALEScreen &screen, const ALERA
 
 int BPROFeatures::getNumberOfFeatures(){
     return numBasicFeatures + numRelativeFeatures + 1;
-}
-
-void BPROFeatures::resetBproExistence(vector<vector<bool> >& bproExistence, vector<tuple<int,int> >& changed){
-    for (vector<tuple<int,int> >::iterator it = changed.begin();it!=changed.end();it++){
-        bproExistence[get<0>(*it)][get<1>(*it)]=true;
-    }
-    changed.clear();
 }
\ No newline at end of file
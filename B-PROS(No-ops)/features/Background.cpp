@@ -1,6 +1,6 @@
 /****************************************************************************************
 ** This class is used to store the background, which may be removed from features.
-** 
+**
 ** Author: Marlos C. Machado
 ***************************************************************************************/
 
@@ -10,57 +10,124 @@
 #endif
 #include <fstream>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char BINARY_MAGIC[4] = {'B', 'G', 'B', '2'};
+static const int BINARY_HEADER_SIZE = 12;
 
 Background::Background(){}
 
 Background::Background(Parameters *param){
+	this->width = 0;
+	this->height = 0;
+	this->pixels = NULL;
+	this->mappedFile = NULL;
+	this->mappedSize = 0;
+
+	std::string textPath = param->getPathToBackground();
+	std::string binaryPath = textPath + "b";
+
+	//The binary file is only used if it was generated after the last change in the text file
+	struct stat textStat, binaryStat;
+	bool hasText = stat(textPath.c_str(), &textStat) == 0;
+	bool hasBinary = stat(binaryPath.c_str(), &binaryStat) == 0;
+	if(hasBinary && (!hasText || binaryStat.st_mtime >= textStat.st_mtime) && loadBinary(binaryPath)){
+		return;
+	}
+
+	loadText(textPath);
+}
+
+//32-bit little-endian integer, as struct.pack('<i') writes it
+static int readInt32(const unsigned char* bytes){
+	return (int) ((unsigned int) bytes[0] | (unsigned int) bytes[1] << 8 | (unsigned int) bytes[2] << 16 | (unsigned int) bytes[3] << 24);
+}
+
+bool Background::loadBinary(std::string path){
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0){
+		return false;
+	}
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) != 0 || fileStat.st_size < BINARY_HEADER_SIZE){
+		close(fd);
+		return false;
+	}
+	void* mapped = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapped == MAP_FAILED){
+		return false;
+	}
+
+	const unsigned char* file = (const unsigned char*) mapped;
+	int fileWidth = readInt32(file + 4);
+	int fileHeight = readInt32(file + 8);
+	if(memcmp(file, BINARY_MAGIC, 4) != 0 || fileWidth <= 0 || fileHeight <= 0
+		|| fileStat.st_size != BINARY_HEADER_SIZE + (off_t) fileWidth * fileHeight){
+		munmap(mapped, fileStat.st_size);
+		return false;
+	}
+
+	this->width = fileWidth;
+	this->height = fileHeight;
+	this->mappedFile = mapped;
+	this->mappedSize = fileStat.st_size;
+	this->pixels = file + BINARY_HEADER_SIZE;
+	return true;
+}
+
+void Background::loadText(std::string path){
 	std::string line;
 	std::string token;
 	std::string delimiter = ",";
 	int row = 0;
 	int col = 0;
-	//TODO: Make this code more robust
-	int ratio = 2;
 
 	//Open background file
-	std::ifstream backgroundFile(param->getPathToBackground().c_str());
+	std::ifstream backgroundFile(path.c_str());
 
 	if (backgroundFile.is_open()){
 		//First read the matrix dimensions and allocate background
 		getline(backgroundFile, line);
-		
+
 		size_t pos = 0;
 		//I assume the first line is the height x width
-		
+
 		pos = line.find(delimiter);
 		this->width = atoi(line.substr(0, pos).c_str());
 		line.erase(0, pos + delimiter.length());
 		this->height = atoi(line.c_str());
 
-		//Dynamically allocate the background matrix
-		for(int i = 0; i < height; i++){
-			background.push_back(std::vector<int>(width, 0));
-		}
+		ownedPixels.assign(this->width * this->height, 0);
 
 		//Read file line by line, adding parsed elements to matrix:
-		while(getline(backgroundFile, line)){
+		while(getline(backgroundFile, line) && row < this->height){
 			if(line.length() > 0){
 				col = 0;
 				while ((pos = line.find(delimiter)) != std::string::npos) {
-			    	this->background[row][col] = atoi(line.substr(0, pos).c_str());
+			    	this->ownedPixels[row * this->width + col] = atoi(line.substr(0, pos).c_str());
 			    	line.erase(0, pos + 1);
 			    	col++;
 				}
-				this->background[row][col] = atoi(line.c_str());
+				this->ownedPixels[row * this->width + col] = atoi(line.c_str());
 				row++;
 			}
 		}
 		backgroundFile.close();
+		this->pixels = &ownedPixels[0];
 	}
 }
 
 int Background::getPixel(int x, int y){
-	return this->background[x][y];
+	return this->pixels[x * this->width + y];
+}
+
+const unsigned char* Background::getRow(int y){
+	return this->pixels + y * this->width;
 }
 
 int Background::getWidth(){
@@ -71,4 +138,8 @@ int Background::getHeight(){
 	return this->height;
 }
 
-Background::~Background(){}
+Background::~Background(){
+	if(this->mappedFile != NULL){
+		munmap(this->mappedFile, this->mappedSize);
+	}
+}
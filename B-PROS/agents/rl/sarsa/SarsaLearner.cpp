@@ -14,8 +14,13 @@
 #include "../../../common/Timer.hpp"
 #endif
 #include "SarsaLearner.hpp"
+#ifndef GZ_STREAM_H
+#define GZ_STREAM_H
+#include "../../../common/GzStream.hpp"
+#endif
 #include <stdio.h>
 #include <math.h>
+#include <algorithm>
 using namespace std;
 
 SarsaLearner::SarsaLearner(ALEInterface& ale, Features *features, Parameters *param,int seed) : RLLearner(ale, param,seed) {
@@ -30,6 +35,7 @@ SarsaLearner::SarsaLearner(ALEInterface& ale, Features *features, Parameters *pa
 	numFeatures = features->getNumberOfFeatures();
     toSaveCheckPoint = param->getToSaveCheckPoint();
     saveWeightsEveryXFrames = param->getFrequencySavingWeights();
+    compressionLevel = param->getCompressionLevel();
 	pathWeightsFileToLoad = param->getPathToWeightsFiles();
     featureSeen.resize(numActions);
 	
@@ -37,22 +43,22 @@ SarsaLearner::SarsaLearner(ALEInterface& ale, Features *features, Parameters *pa
 		//Initialize Q;
 		Q.push_back(0);
 		Qnext.push_back(0);
-		//Initialize e:
-		e.push_back(vector<float>(numFeatures, 0.0));
-		w.push_back(vector<float>(numFeatures, 0.0));
 		nonZeroElig.push_back(vector<int>());
 	}
+	//Initialize e and w, no memory is used until a feature is seen
+	e.init(numActions, numFeatures);
+	w.init(numActions, numFeatures);
     
     episodePassed = 0;
 	if(toSaveCheckPoint){
         checkPointName = param->getCheckPointName();
         //load CheckPoint
-        std::ifstream checkPointToLoad;
         string checkPointLoadName = checkPointName+"-checkPoint.txt";
-        checkPointToLoad.open(checkPointLoadName.c_str());
+        GzInputStream checkPointToLoad(checkPointLoadName);
 	//printf("Loading checkpoint (%s)...", checkPointLoadName.c_str());        
 	if (checkPointToLoad.is_open()){
             loadCheckPoint(checkPointToLoad);
+            checkPointToLoad.close();
             remove(checkPointLoadName.c_str());
         }
         saveThreshold = (totalNumberFrames/saveWeightsEveryXFrames)*saveWeightsEveryXFrames;
@@ -73,7 +79,7 @@ void SarsaLearner::updateQValues(vector<int> &Features, vector<float> &QValues){
 	for(int a = 0; a < numActions; a++){
 		double sumW = 0;
 		for(unsigned int i = 0; i < Features.size(); i++){
-			sumW += w[a][Features[i]];
+			sumW += w.get(a, Features[i]);
 		}
 		QValues[a] = sumW;
 	}
@@ -87,9 +93,9 @@ void SarsaLearner::updateReplTrace(int action, vector<int> &Features){
 	 		int idx = nonZeroElig[a][i];
 	 		//To keep the trace sparse, if it is
 	 		//less than a threshold it is zero-ed.
-			e[a][idx] = gamma * lambda * e[a][idx];
-			if(e[a][idx] < traceThreshold){
-				e[a][idx] = 0;
+			e(a,idx) = gamma * lambda * e.get(a,idx);
+			if(e.get(a,idx) < traceThreshold){
+				e(a,idx) = 0;
 			}
 			else{
 				nonZeroElig[a][numNonZero] = idx;
@@ -104,10 +110,10 @@ void SarsaLearner::updateReplTrace(int action, vector<int> &Features){
 		int idx = Features[i];
 		//If the trace is zero it is not in the vector
 		//of non-zeros, thus it needs to be added
-		if(e[action][idx] == 0){
+		if(e.get(action,idx) == 0){
 	       nonZeroElig[action].push_back(idx);
 	    }
-		e[action][idx] = 1;
+		e(action,idx) = 1;
 	}
 }
 
@@ -119,9 +125,9 @@ void SarsaLearner::updateAcumTrace(int action, vector<int> &Features){
 	 		int idx = nonZeroElig[a][i];
 	 		//To keep the trace sparse, if it is
 	 		//less than a threshold it is zero-ed.
-			e[a][idx] = gamma * lambda * e[a][idx];
-			if(e[a][idx] < traceThreshold){
-				e[a][idx] = 0;
+			e(a,idx) = gamma * lambda * e.get(a,idx);
+			if(e.get(a,idx) < traceThreshold){
+				e(a,idx) = 0;
 			}
 			else{
 				nonZeroElig[a][numNonZero] = idx;
@@ -136,10 +142,10 @@ void SarsaLearner::updateAcumTrace(int action, vector<int> &Features){
 		int idx = Features[i];
 		//If the trace is zero it is not in the vector
 		//of non-zeros, thus it needs to be added
-		if(e[action][idx] == 0){
+		if(e.get(action,idx) == 0){
 	       nonZeroElig[action].push_back(idx);
 	    }
-		e[action][idx] += 1;
+		e(action,idx) += 1;
 	}
 }
 
@@ -175,8 +181,7 @@ void SarsaLearner::saveCheckPoint(int episode, int totalNumberFrames, vector<flo
     
     //write parameters checkPoint
     string currentCheckPointName = checkPointName+"-checkPoint-Frames"+std::to_string((long long) saveThreshold)+"-writing.txt";
-    ofstream checkPointFile;
-    checkPointFile.open(currentCheckPointName.c_str());
+    GzOutputStream checkPointFile(currentCheckPointName, compressionLevel);
     checkPointFile<<agentRand<<endl;
     checkPointFile<<totalNumberFrames<<endl;
     checkPointFile << episode<<endl;
@@ -184,7 +189,7 @@ void SarsaLearner::saveCheckPoint(int episode, int totalNumberFrames, vector<flo
     checkPointFile << maxFeatVectorNorm<<endl;
     for (int a=0;a<featureSeen.size();a++){
         for (int index=0; index<featureSeen[a].size();index++){
-            checkPointFile<<a<<" "<<featureSeen[a][index]<<" "<<w[a][featureSeen[a][index]]<<"\t";
+            checkPointFile<<a<<" "<<featureSeen[a][index]<<" "<<w.get(a,featureSeen[a][index])<<"\t";
         }
     }
     checkPointFile << endl;
@@ -197,7 +202,7 @@ void SarsaLearner::saveCheckPoint(int episode, int totalNumberFrames, vector<flo
 
 }
 
-void SarsaLearner::loadCheckPoint(std::ifstream& checkPointToLoad){
+void SarsaLearner::loadCheckPoint(std::istream& checkPointToLoad){
     checkPointToLoad >> agentRand;
     checkPointToLoad >> totalNumberFrames;
     checkPointToLoad >> episodePassed;
@@ -206,9 +211,8 @@ void SarsaLearner::loadCheckPoint(std::ifstream& checkPointToLoad){
     int action, index;
     float weight;
     while (checkPointToLoad>>action && checkPointToLoad>>index && checkPointToLoad>>weight){
-        w[action][index] = weight;
+        w(action,index) = weight;
     }
-    checkPointToLoad.close();
 }
 
 void SarsaLearner::learnPolicy(ALEInterface& ale, Features *features){
@@ -229,7 +233,7 @@ void SarsaLearner::learnPolicy(ALEInterface& ale, Features *features){
 		for(unsigned int a = 0; a < nonZeroElig.size(); a++){
 			for(unsigned int i = 0; i < nonZeroElig[a].size(); i++){
 				int idx = nonZeroElig[a][i];
-				e[a][idx] = 0.0;
+				e(a,idx) = 0.0;
 			}
 			nonZeroElig[a].clear();
 		}
@@ -276,10 +280,10 @@ void SarsaLearner::learnPolicy(ALEInterface& ale, Features *features){
 			for(unsigned int a = 0; a < nonZeroElig.size(); a++){
 				for(unsigned int i = 0; i < nonZeroElig[a].size(); i++){
 					int idx = nonZeroElig[a][i];
-                    if (w[a][idx]==0 && delta!=0){
+                    if (w.get(a,idx)==0 && delta!=0){
                         featureSeen[a].push_back(idx);
                     }
-					w[a][idx] = w[a][idx] + (alpha/maxFeatVectorNorm) * delta * e[a][idx];
+					w(a,idx) = w.get(a,idx) + (alpha/maxFeatVectorNorm) * delta * e.get(a,idx);
                     
 				}
 			}
@@ -351,13 +355,20 @@ void SarsaLearner::evaluatePolicy(ALEInterface& ale, Features *features){
 }
 
 void SarsaLearner::saveWeightsToFile(string suffix){
-    std::ofstream weightsFile ((nameWeightsFile + suffix).c_str());
+    GzOutputStream weightsFile(nameWeightsFile + suffix, compressionLevel);
     if(weightsFile.is_open()){
-        weightsFile << w.size() << " " << w[0].size() << std::endl;
-        for(unsigned int i = 0; i < w.size(); i++){
-            for(unsigned int j = 0; j < w[i].size(); j++){
-                if(w[i][j] != 0){
-                    weightsFile << i << " " << j << " " << w[i][j] << std::endl;
+        weightsFile << w.getNumActions() << " " << w.getNumFeatures() << std::endl;
+        for(int i = 0; i < w.getNumActions(); i++){
+            for(long long page = 0; page < w.getPagesPerAction(); page++){
+                //Pages never written only have zeros
+                if(!w.isPageAllocated(i, page)){
+                    continue;
+                }
+                long long end = std::min((page + 1) * PagedWeightTable::PAGE_SIZE, w.getNumFeatures());
+                for(long long j = page * PagedWeightTable::PAGE_SIZE; j < end; j++){
+                    if(w.get(i,j) != 0){
+                        weightsFile << i << " " << j << " " << w.get(i,j) << std::endl;
+                    }
                 }
             }
         }
@@ -374,13 +385,13 @@ void SarsaLearner::loadWeights(){
     int i, j;
     double value;
     
-    std::ifstream weightsFile (pathWeightsFileToLoad.c_str());
+    GzInputStream weightsFile(pathWeightsFileToLoad);
     
     weightsFile >> nActions >> nFeatures;
     assert(nActions == numActions);
     assert(nFeatures == numFeatures);
     
     while(weightsFile >> i >> j >> value){
-        w[i][j] = value;
+        w(i,j) = value;
     }
 }
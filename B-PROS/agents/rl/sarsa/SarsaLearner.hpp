@@ -13,6 +13,10 @@
 #define RLLEARNER_H
 #include "../RLLearner.hpp"
 #endif
+#ifndef PAGED_WEIGHT_TABLE_H
+#define PAGED_WEIGHT_TABLE_H
+#include "../../../common/PagedWeightTable.hpp"
+#endif
 #include <vector>
 
 class SarsaLearner : public RLLearner{
@@ -20,6 +24,7 @@ class SarsaLearner : public RLLearner{
 		float alpha, delta, lambda, traceThreshold;
 		int numFeatures, currentAction, nextAction;
 		int toSaveWeightsAfterLearning, saveWeightsEveryXFrames, toSaveCheckPoint;
+		int compressionLevel;				//zlib level of the check points and weights files, 0 to not compress them
 
 		std::string nameWeightsFile, pathWeightsFileToLoad;
         std::string checkPointName;
@@ -33,8 +38,8 @@ class SarsaLearner : public RLLearner{
 		std::vector<int> Fnext;              //Set of features active in next state
 		std::vector<float> Q;               //Q(a) entries
 		std::vector<float> Qnext;           //Q(a) entries for next action
-		std::vector<std::vector<float> > e;      //Eligibility trace
-		std::vector<std::vector<float> > w;      //Theta, weights vector
+		PagedWeightTable e;            //Eligibility trace, pages allocated as features are seen
+		PagedWeightTable w;            //Theta, weights vector, pages allocated as features are seen
 		std::vector<std::vector<int> >nonZeroElig;//To optimize the implementation
         	std::vector<std::vector<int> > featureSeen;
     
@@ -77,7 +82,7 @@ class SarsaLearner : public RLLearner{
         */
         void loadWeights();
         void saveCheckPoint(int episode, int totalNumberFrames,  std::vector<float>& episodeResults, int& frequency, std::vector<int>& episodeFrames, std::vector<double>& episodeFps);
-        void loadCheckPoint(std::ifstream& checkPointToLoad);
+        void loadCheckPoint(std::istream& checkPointToLoad);
     public:
 		SarsaLearner(ALEInterface& ale, Features *features, Parameters *param,int seed);
 		/**
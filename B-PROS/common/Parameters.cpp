@@ -196,6 +196,24 @@ void Parameters::parseParametersFromConfigFile(std::string cfgFileName){
 		std::string folderWithBackgrounds = parameters["PATH_TO_BACKGROUND"];
 		setPathToBackground(folderWithBackgrounds, this->gameBeingPlayed);
 	}
+    
+    if (parameters.count("BPRO_GENERATOR")>0){
+        this->setBproGenerator(atoi(parameters["BPRO_GENERATOR"].c_str()));
+    }else{
+        this->setBproGenerator(0);
+    }
+    
+    if (parameters.count("INCREMENTAL_FEATURES")>0){
+        this->setIncrementalFeatures(atoi(parameters["INCREMENTAL_FEATURES"].c_str()));
+    }else{
+        this->setIncrementalFeatures(0);
+    }
+    
+    if (parameters.count("COMPRESSION_LEVEL")>0){
+        this->setCompressionLevel(atoi(parameters["COMPRESSION_LEVEL"].c_str()));
+    }else{
+        this->setCompressionLevel(0);
+    }
 }
 
 void Parameters::setSaveTrajectoryPath(std::string name){
@@ -446,3 +464,26 @@ int Parameters::getToSaveCheckPoint(){
     return this->toSaveCheckPoint;
 }
 
+void Parameters::setBproGenerator(int a){
+    this->bproGenerator = a;
+}
+
+int Parameters::getBproGenerator(){
+    return this->bproGenerator;
+}
+
+void Parameters::setIncrementalFeatures(int a){
+    this->incrementalFeatures = a;
+}
+
+int Parameters::getIncrementalFeatures(){
+    return this->incrementalFeatures;
+}
+
+void Parameters::setCompressionLevel(int a){
+    this->compressionLevel = a;
+}
+
+int Parameters::getCompressionLevel(){
+    return this->compressionLevel;
+}
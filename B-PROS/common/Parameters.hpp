@@ -50,6 +50,9 @@ class Parameters{
 		int frequencySavingWeights;     //If we are asked to save the weights, We need to know how many frames to wait until saving them again
 		int toLoadWeights;              //whether we are going to load an already learned set of weights or not
 		int learningLength;             //The number of frames to be learned, in total. DQN uses, for example, 50,000,000.
+		int bproGenerator;              //0: enumerate all pairs of tiles, 1: correlate per-color occupancy bitmasks
+		int incrementalFeatures;        //whether tiles and pairwise offsets are updated only where the screen changed
+		int compressionLevel;           //zlib level of the check points and weights files written, 0 to write them uncompressed
 
 	   /**
  		* Constructor defined as private to force the use of the constructor 
@@ -216,6 +219,9 @@ class Parameters{
 		void setLearningLength(int a);
         void setToSaveCheckPoint(int a);
         void setCheckPointName(std::string fileName);
+        void setBproGenerator(int a);
+        void setIncrementalFeatures(int a);
+        void setCompressionLevel(int a);
 		
 	public:
 		/**
@@ -350,4 +356,7 @@ class Parameters{
 		int getLearningLength();
         int getToSaveCheckPoint();
         std::string getCheckPointName();
+        int getBproGenerator();
+        int getIncrementalFeatures();
+        int getCompressionLevel();
 };
@@ -0,0 +1,49 @@
+/****************************************************************************************
+ ** Set of small integers that is emptied in constant time, used by the feature extractors
+ ** to add each offset only once per pair of colors. Every entry has a 16-bit stamp and an
+ ** entry is in the set when its stamp is the current epoch, so emptying the set is moving
+ ** to the next epoch instead of going back over the entries that were added.
+ **
+ ** REMARKS: - Once every 65535 epochs the stamps are cleared, before old ones could be
+ **            taken as of the current epoch.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#include <algorithm>
+#include <vector>
+#include <stddef.h>
+
+class StampTable{
+private:
+    std::vector<unsigned short> stamps;
+    unsigned short epoch;
+
+public:
+    StampTable() : epoch(1){}
+    /**
+     * Entries from 0 to size-1, the set is empty.
+     */
+    void resize(size_t size){
+        stamps.assign(size, 0);
+        epoch = 1;
+    }
+    void clear(){
+        epoch++;
+        if (epoch == 0){
+            std::fill(stamps.begin(), stamps.end(), 0);
+            epoch = 1;
+        }
+    }
+    /**
+     * Adds the entry to the set.
+     * @return bool true if it was not in the set
+     */
+    bool insert(size_t entry){
+        if (stamps[entry] == epoch){
+            return false;
+        }
+        stamps[entry] = epoch;
+        return true;
+    }
+};
@@ -16,6 +16,10 @@
 #define BACKGROUND_H
 #include "Background.hpp"
 #endif
+#ifndef STAMP_TABLE_H
+#define STAMP_TABLE_H
+#include "../common/StampTable.hpp"
+#endif
 
 #include<tuple>
 
@@ -30,14 +34,28 @@ class BPROFeatures : public Features::Features{
     	int numRelativeFeatures;
     	int rowLess0Shift, row0Shift, rowMore0Shift;
         int numColumns, numRows, numColors;
-        vector<vector<bool> > bproExistence;
-        vector<tuple<int,int> > changed;
+        StampTable bproStamps;                      //offsets added for the current pair of colors
+        vector<int> activeColors;                   //colors with at least one tile in the current frame
+    
+        vector<unsigned long long> tileColors;      //128-bit color-presence mask per tile, two words each
+        vector<int> columnToTile;                   //tile column of each screen column
+        vector<unsigned char> previousScreen;       //last screen seen in incremental mode, used to find the dirty tiles
+        vector<unsigned short> pairOffsetCounts;    //pairs of tiles at each offset of each color pair, in incremental mode
+        vector<unsigned long long> pairOffsetRows;  //offsets with a nonzero count, one word per row offset of each color pair
+        vector<int> colorTileCount;                 //number of tiles of each color, in incremental mode
+        unsigned long long presentColors[2];        //colors with a nonzero tile count
+        vector<unsigned int> colorOccupancy;        //tiles of each color, one bit per column and one word per row
+        vector<unsigned long long> offsetRows;      //offsets found for a color pair, one bit per column offset
     
+        void quantizeRow(const unsigned char* row, const unsigned char* backgroundRow, unsigned char* quantized, int width);
+        void updateDirtyTiles(const ALEScreen &screen, int blockWidth, int blockHeight);
+        void updatePairOffsetCounts(int row, int column, int color, int delta);
         int getBasicFeaturesIndices(const ALEScreen &screen, int blockWidth, int blockHeight,
             vector<vector<tuple<int,int> > > &whichColors, vector<int>& features);
 		void addRelativeFeaturesIndices(const ALEScreen &screen, int featureIndex,
             vector<vector<tuple<int,int> > > &whichColors, vector<int>& features);
-    void resetBproExistence(vector<vector<bool> >& bproExistence, vector<tuple<int,int> >& changed);
+        void addRelativeFeaturesIndicesFromMasks(vector<vector<tuple<int,int> > > &whichColors, vector<int>& features);
+        void addRelativeFeaturesIndicesFromCounts(vector<int>& features);
 	public:
 		/**
 		* Destructor, used to delete the background, which is allocated dynamically.
@@ -14,13 +14,47 @@
 #include "../../../common/Timer.hpp"
 #endif
 #include "SarsaLearner.hpp"
+#ifndef GZ_STREAM_H
+#define GZ_STREAM_H
+#include "../../../common/GzStream.hpp"
+#endif
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include <set>
+#include <sstream>
+#include <algorithm>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 using namespace std;
 //using google::dense_hash_map;
 
-SarsaLearner::SarsaLearner(ALEInterface& ale, Features *features, Parameters *param,int seed) : RLLearner(ale, param,seed) {
+SharedWeights::SharedWeights(int numActors){
+    this->numActors = numActors;
+    numGroups = 0;
+    totalNumberFrames = 0;
+    pthread_rwlockattr_t attributes;
+    pthread_rwlockattr_init(&attributes);
+#ifdef __GLIBC__
+    //The actors hold the lock shared almost all the time, by default one creating a group would starve
+    pthread_rwlockattr_setkind_np(&attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&lock, &attributes);
+    pthread_rwlockattr_destroy(&attributes);
+}
+
+SharedWeights::~SharedWeights(){
+    pthread_rwlock_destroy(&lock);
+}
+
+SarsaLearner::SarsaLearner(ALEInterface& ale, Features *features, Parameters *param, int seed, SharedWeights* sharedWeights, int actorIndex) : RLLearner(ale, param,seed),
+    ownWeights(sharedWeights == NULL ? new SharedWeights(1) : NULL),
+    shared(sharedWeights == NULL ? ownWeights : sharedWeights),
+    w(shared->w), featureTranslate(shared->featureTranslate), groups(shared->groups), numGroups(shared->numGroups),
+    actionRing(2), transitionRing(2) {
+    actor = actorIndex;
+    hogwild = shared->numActors > 1;
     
     totalNumberFrames = 0.0;
     maxFeatVectorNorm = 1;
@@ -30,7 +64,6 @@ SarsaLearner::SarsaLearner(ALEInterface& ale, Features *features, Parameters *pa
     alpha = param->getAlpha();
     learningRate = alpha;
     lambda = param->getLambda();
-    numGroups = 0;
     traceThreshold = param->getTraceThreshold();
     numFeatures = features->getNumberOfFeatures();
     toSaveCheckPoint = param->getToSaveCheckPoint();
@@ -39,28 +72,66 @@ SarsaLearner::SarsaLearner(ALEInterface& ale, Features *features, Parameters *pa
     randomNoOp = param->getRandomNoOp();
     noOpMax = param->getNoOpMax();
     numStepsPerAction = param->getNumStepsPerAction();
+    evaluationSeed = param->getSeed();
     
     for(int i = 0; i < numActions; i++){
         //Initialize Q;
         Q.push_back(0);
         Qnext.push_back(0);
-        //Initialize e:
-        e.push_back(vector<float>());
-        w.push_back(vector<float>());
         nonZeroElig.push_back(vector<long long>());
     }
+    //Initialize w and e, with one entry per action for each group. The
+    //weights and groups are shared by all actors, the first one initializes them:
+    if(actor == 0){
+        w.init(numActions, param->getWeightsLayout());
+        featureTranslate.clear();
+        numGroups = 0;
+    }
+    e.init(numActions, param->getWeightsLayout());
+    lazyTraces = param->getLazyTraces();
+    fusedTraceUpdate = param->getFusedTraceUpdate();
+    pipelinedExtraction = param->getPipelinedExtraction();
+    checkPointFormat = param->getCheckPointFormat();
+    asyncCheckPoint = param->getAsyncCheckPoint();
+    compressionLevel = param->getCompressionLevel();
+    deltaCheckPoints = param->getDeltaCheckPoints();
+    deltasSinceFull = -1;
+    fullTotalNumberFrames = 0;
+    fullThreshold = 0;
+    traceStep = 0;
+    if(lazyTraces){
+        eStep.init(numActions, param->getWeightsLayout());
+        traceDecay.push_back(1.0);
+    }
     episodePassed = 0;
-    featureTranslate.clear();
-    featureTranslate.max_load_factor(0.5);
-    if(toSaveCheckPoint){
+    if(toSaveCheckPoint && actor == 0){
         checkPointName = param->getCheckPointName();
-        //load CheckPoint
-        ifstream checkPointToLoad;
-        string checkPointLoadName = checkPointName+"-checkPoint.txt";
-        checkPointToLoad.open(checkPointLoadName.c_str());
-        if (checkPointToLoad.is_open()){
-            loadCheckPoint(checkPointToLoad);
+        //load CheckPoint, in any of the two formats
+        string checkPointLoadName = checkPointName+"-checkPoint.bin";
+        if (!ifstream(checkPointLoadName.c_str()).good()){
+            checkPointLoadName = checkPointName+"-checkPoint.txt";
+        }
+        if (ifstream(checkPointLoadName.c_str()).good()){
+            CheckPoint checkPoint;
+            string error;
+            bool loaded = CheckPointIO::isBinary(checkPointLoadName) ? CheckPointIO::loadBinary(checkPointLoadName, checkPoint, error) : CheckPointIO::loadText(checkPointLoadName, numActions, checkPoint, error);
+            if (!loaded || checkPoint.numActions != numActions){
+                printf("Unable to load the check point: %s\n", loaded ? "it has a different number of actions" : error.c_str());
+                exit(1);
+            }
             remove(checkPointLoadName.c_str());
+            //and the changes since it, if a delta was also written
+            string deltaLoadName = checkPointName+"-checkPointDelta.bin";
+            if (ifstream(deltaLoadName.c_str()).good()){
+                CheckPoint delta;
+                if (!CheckPointIO::loadDelta(deltaLoadName, delta, error) || !CheckPointIO::applyDelta(checkPoint, delta, error)){
+                    printf("Unable to load the delta check point: %s\n", error.c_str());
+                    exit(1);
+                }
+                remove(deltaLoadName.c_str());
+            }
+            loadCheckPoint(checkPoint);
+            shared->totalNumberFrames = totalNumberFrames;
         }
         saveThreshold = (totalNumberFrames/saveWeightsEveryXFrames)*saveWeightsEveryXFrames;
         ofstream learningConditionFile;
@@ -73,20 +144,115 @@ SarsaLearner::SarsaLearner(ALEInterface& ale, Features *features, Parameters *pa
     }
 }
 
-SarsaLearner::~SarsaLearner(){}
+SarsaLearner::~SarsaLearner(){
+    waitForCheckPoint();
+    delete ownWeights;
+}
+
+void SarsaLearner::extractFeatures(ALEInterface& ale, Features *features){
+    for(int action = actionRing.front(); action >= 0; action = actionRing.front()){
+        actionRing.pop();
+        Transition& transition = transitionRing.getWriteSlot();
+        transition.reward.resize(2);
+        transition.reward[0] = 0.0;
+        transition.reward[1] = 0.0;
+        act(ale, action, transition.reward);
+        transition.gameOver = ale.game_over();
+        transition.features.clear();
+        if(!transition.gameOver){
+            features->getActiveFeaturesIndices(ale.getScreen(), ale.getRAM(), transition.features);
+        }
+        transitionRing.push();
+    }
+    actionRing.pop();
+}
+
+void SarsaLearner::lockWeights(int exclusive){
+    if(hogwild){
+        if(exclusive){
+            pthread_rwlock_wrlock(&shared->lock);
+        }else{
+            pthread_rwlock_rdlock(&shared->lock);
+        }
+    }
+}
+
+void SarsaLearner::unlockWeights(){
+    if(hogwild){
+        pthread_rwlock_unlock(&shared->lock);
+    }
+}
 
 void SarsaLearner::updateQValues(vector<long long> &Features, vector<float> &QValues){
-    unsigned long long featureSize = Features.size();
-    for(int a = 0; a < numActions; ++a){
-        float sumW = 0;
-        for(unsigned long long i = 0; i < featureSize; ++i){
-            sumW = sumW + w[a][Features[i]]*groups[Features[i]].numFeatures;
+    w.sumGroups(Features, [this](long long group){ return groups[group].numFeatures; }, &QValues[0]);
+}
+
+void SarsaLearner::updateFrozenQValues(vector<long long> &Features, vector<float> &QValues){
+    if(activeGroupCount.size() < numGroups){
+        activeGroupCount.resize(numGroups, 0);
+    }
+    vector<long long> activeGroupIndices;
+    for(unsigned long long i = 0; i < Features.size(); i++){
+        int featureGroup = shared->frozenTranslate.get(Features[i]);
+        if(featureGroup != 0){
+            if(activeGroupCount[featureGroup-1] == 0){
+                activeGroupIndices.push_back(featureGroup-1);
+            }
+            activeGroupCount[featureGroup-1]++;
         }
-        QValues[a] = sumW;
+    }
+    w.sumGroups(activeGroupIndices, [this](long long group){ return activeGroupCount[group]; }, &QValues[0]);
+    for(unsigned long long i = 0; i < activeGroupIndices.size(); i++){
+        activeGroupCount[activeGroupIndices[i]] = 0;
     }
 }
 
+float SarsaLearner::getTrace(int action, long long group){
+    if(!lazyTraces && fusedTraceUpdate){
+        float trace = e(action,group);
+        return trace < 0 ? 1 : gamma * lambda * trace;
+    }
+    //Zero traces may have the step of a previous episode
+    if(!lazyTraces || e(action,group) == 0){
+        return e(action,group);
+    }
+    int numDecays = traceStep - eStep(action,group);
+    while(numDecays >= traceDecay.size()){
+        traceDecay.push_back(gamma * lambda * traceDecay.back());
+    }
+    return e(action,group) * traceDecay[numDecays];
+}
+
+void SarsaLearner::setTrace(int action, long long group, float value){
+    e(action,group) = value;
+    eStep(action,group) = traceStep;
+}
+
 void SarsaLearner::updateReplTrace(int action, vector<long long> &Features){
+    if(lazyTraces){
+        //e <- gamma * lambda * e, for all traces at once
+        traceStep++;
+        for(unsigned int i = 0; i < F.size(); i++){
+            long long idx = Features[i];
+            //Traces still in nonZeroElig are not zero, even if they are already below the threshold
+            if(e(action,idx) == 0){
+                nonZeroElig[action].push_back(idx);
+            }
+            setTrace(action, idx, 1);
+        }
+        return;
+    }
+    if(fusedTraceUpdate){
+        //The traces are decayed later, in decayTracesAndUpdateWeights, -1 means they are set to 1 then
+        for(unsigned int i = 0; i < F.size(); i++){
+            long long idx = Features[i];
+            if(e(action,idx) == 0){
+                nonZeroElig[action].push_back(idx);
+            }
+            e(action,idx) = -1;
+        }
+        return;
+    }
     //e <- gamma * lambda * e
     for(unsigned int a = 0; a < nonZeroElig.size(); a++){
         long long numNonZero = 0;
@@ -94,9 +260,9 @@ void SarsaLearner::updateReplTrace(int action, vector<long long> &Features){
             long long idx = nonZeroElig[a][i];
             //To keep the trace sparse, if it is
             //less than a threshold it is zero-ed.
-            e[a][idx] = gamma * lambda * e[a][idx];
-            if(e[a][idx] < traceThreshold){
-                e[a][idx] = 0;
+            e(a,idx) = gamma * lambda * e(a,idx);
+            if(e(a,idx) < traceThreshold){
+                e(a,idx) = 0;
             }
             else{
                 nonZeroElig[a][numNonZero] = idx;
@@ -111,14 +277,33 @@ void SarsaLearner::updateReplTrace(int action, vector<long long> &Features){
         long long idx = Features[i];
         //If the trace is zero it is not in the vector
         //of non-zeros, thus it needs to be added
-        if(e[action][idx] == 0){
+        if(e(action,idx) == 0){
             nonZeroElig[action].push_back(idx);
         }
-        e[action][idx] = 1;
+        e(action,idx) = 1;
     }
 }
 
 void SarsaLearner::updateAcumTrace(int action, vector<long long> &Features){
+    if(lazyTraces){
+        //e <- gamma * lambda * e, for all traces at once
+        traceStep++;
+        for(unsigned int i = 0; i < F.size(); i++){
+            long long idx = Features[i];
+            float trace = 0;
+            if(e(action,idx) == 0){
+                nonZeroElig[action].push_back(idx);
+            }else{
+                trace = getTrace(action, idx);
+                //It would have been zero-ed before being incremented
+                if(trace < traceThreshold){
+                    trace = 0;
+                }
+            }
+            setTrace(action, idx, trace + 1);
+        }
+        return;
+    }
     //e <- gamma * lambda * e
     for(unsigned int a = 0; a < nonZeroElig.size(); a++){
         long long numNonZero = 0;
@@ -126,9 +311,9 @@ void SarsaLearner::updateAcumTrace(int action, vector<long long> &Features){
             long long idx = nonZeroElig[a][i];
             //To keep the trace sparse, if it is
             //less than a threshold it is zero-ed.
-            e[a][idx] = gamma * lambda * e[a][idx];
-            if(e[a][idx] < traceThreshold){
-                e[a][idx] = 0;
+            e(a,idx) = gamma * lambda * e(a,idx);
+            if(e(a,idx) < traceThreshold){
+                e(a,idx) = 0;
             }
             else{
                 nonZeroElig[a][numNonZero] = idx;
@@ -143,10 +328,104 @@ void SarsaLearner::updateAcumTrace(int action, vector<long long> &Features){
         long long idx = Features[i];
         //If the trace is zero it is not in the vector
         //of non-zeros, thus it needs to be added
-        if(e[action][idx] == 0){
+        if(e(action,idx) == 0){
             nonZeroElig[action].push_back(idx);
         }
-        e[action][idx] += 1;
+        e(action,idx) += 1;
+    }
+}
+
+void SarsaLearner::decayTracesAndUpdateWeights(float weightStep){
+    float decay = gamma * lambda;
+    for(unsigned int a = 0; a < nonZeroElig.size(); a++){
+        vector<long long>& indices = nonZeroElig[a];
+        unsigned long long numIndices = indices.size();
+        unsigned long long numNonZero = 0;
+        unsigned long long i = 0;
+        while(i < numIndices){
+            long long idx = indices[i];
+#ifdef __SSE__
+            //In the action-major layout consecutive groups of an action are contiguous
+            if(!e.isGroupMajor() && i + 4 <= numIndices && indices[i+1] == idx+1 && indices[i+2] == idx+2 && indices[i+3] == idx+3){
+                float* tracePointer = &e(a,idx);
+                float* weightPointer = &w(a,idx);
+                __m128 traces = _mm_loadu_ps(tracePointer);
+                __m128 marked = _mm_cmplt_ps(traces, _mm_setzero_ps());
+                traces = _mm_or_ps(_mm_and_ps(marked, _mm_set1_ps(1)), _mm_andnot_ps(marked, _mm_mul_ps(_mm_set1_ps(decay), traces)));
+                __m128 kept = _mm_cmpnlt_ps(traces, _mm_set1_ps(traceThreshold));
+                traces = _mm_and_ps(traces, kept);
+                _mm_storeu_ps(tracePointer, traces);
+                //Zero-ed traces add 0 to their weights
+                _mm_storeu_ps(weightPointer, _mm_add_ps(_mm_loadu_ps(weightPointer), _mm_mul_ps(_mm_set1_ps(weightStep), traces)));
+                int keptMask = _mm_movemask_ps(kept);
+                for(int k = 0; k < 4; k++){
+                    if(keptMask & (1 << k)){
+                        indices[numNonZero] = idx + k;
+                        numNonZero++;
+                    }
+                }
+                i += 4;
+                continue;
+            }
+#endif
+            float trace = e(a,idx);
+            trace = trace < 0 ? 1 : decay * trace;
+            //To keep the trace sparse, if it is
+            //less than a threshold it is zero-ed.
+            if(trace < traceThreshold){
+                e(a,idx) = 0;
+            }
+            else{
+                e(a,idx) = trace;
+                w(a,idx) = w(a,idx) + weightStep * trace;
+                indices[numNonZero] = idx;
+                numNonZero++;
+            }
+            i++;
+        }
+        indices.resize(numNonZero);
+    }
+}
+
+void SarsaLearner::clearTraces(){
+    for(unsigned int a = 0; a < nonZeroElig.size(); a++){
+        for(unsigned long long i = 0; i < nonZeroElig[a].size(); i++){
+            long long idx = nonZeroElig[a][i];
+            e(a,idx) = 0.0;
+        }
+        nonZeroElig[a].clear();
+    }
+    traceStep = 0;
+}
+
+void SarsaLearner::updateWeights(){
+    if(lazyTraces){
+        //The traces that decayed below the threshold are zero-ed here
+        for(unsigned int a = 0; a < nonZeroElig.size(); a++){
+            long long numNonZero = 0;
+            for(unsigned int i = 0; i < nonZeroElig[a].size(); i++){
+                long long idx = nonZeroElig[a][i];
+                float trace = getTrace(a, idx);
+                if(trace < traceThreshold){
+                    e(a,idx) = 0;
+                }
+                else{
+                    w(a,idx) = w(a,idx) + learningRate * delta * trace;
+                    nonZeroElig[a][numNonZero] = idx;
+                    numNonZero++;
+                }
+            }
+            nonZeroElig[a].resize(numNonZero);
+        }
+    }else if(fusedTraceUpdate){
+        decayTracesAndUpdateWeights(learningRate * delta);
+    }else{
+        for(unsigned int a = 0; a < nonZeroElig.size(); a++){
+            for(unsigned int i = 0; i < nonZeroElig[a].size(); i++){
+                long long idx = nonZeroElig[a][i];
+                w(a,idx) = w(a,idx) + learningRate * delta * e(a,idx);
+            }
+        }
     }
 }
 
@@ -180,91 +459,172 @@ void SarsaLearner::saveCheckPoint(int episode, int totalNumberFrames, vector<flo
         nameForLearningCondition = newNameForLearningCondition;
     }
     
-    //write parameters checkPoint
-    string currentCheckPointName = checkPointName+"-checkPoint-Frames"+to_string(saveThreshold)+"-writing.txt";
-    ofstream checkPointFile;
-    checkPointFile.open(currentCheckPointName.c_str());
-    checkPointFile<<(*agentRand)<<endl;
-    checkPointFile<<totalNumberFrames<<endl;
-    checkPointFile << episode<<endl;
-    checkPointFile << firstReward<<endl;
-    checkPointFile << maxFeatVectorNorm<<endl;
-    checkPointFile << numGroups<<endl;
-    checkPointFile << featureTranslate.size()<<endl;
-    vector<int> nonZeroWeights;
-    for (unsigned long long groupIndex=0; groupIndex<numGroups;++groupIndex){
-        nonZeroWeights.clear();
-        for (unsigned long long a=0; a<w.size();a++){
-            if (w[a][groupIndex]!=0){
-                nonZeroWeights.push_back(a);
-            }
+    //write parameters checkPoint, with DELTA_CHECKPOINTS only what changed since the last full one
+    //until DELTA_CHECKPOINTS deltas were written, then a full one again. The check points at every
+    //50M frames are always full, they are the ones that are kept
+    bool delta = deltaCheckPoints > 0 && deltasSinceFull >= 0 && deltasSinceFull < deltaCheckPoints
+        && saveThreshold%50000000 != 0;
+    string extension = checkPointFormat == 1 || delta ? ".bin" : ".txt";
+    string kind = delta ? "-checkPointDelta" : "-checkPoint";
+    string currentCheckPointName = checkPointName+kind+"-Frames"+to_string(saveThreshold)+"-writing"+extension;
+    vector<string> previousVersions;
+    if(deltaCheckPoints > 0){
+        //A delta has all changes since the full check point, so only the last one is needed
+        if(lastDeltaCheckPoint != ""){
+            previousVersions.push_back(lastDeltaCheckPoint);
         }
-        checkPointFile<<nonZeroWeights.size();
-        for (int i=0;i<nonZeroWeights.size();++i){
-            int action = nonZeroWeights[i];
-            checkPointFile<<" "<<action<<" "<<w[action][groupIndex];
+        if(!delta && lastFullCheckPoint != "" && fullThreshold%50000000 != 0){
+            previousVersions.push_back(lastFullCheckPoint);
         }
-        checkPointFile<<"\t";
+    }else if((saveThreshold-saveWeightsEveryXFrames)%50000000 != 0){
+        previousVersions.push_back(checkPointName+"-checkPoint-Frames"+to_string(saveThreshold-saveWeightsEveryXFrames)+"-finished"+extension);
     }
-    checkPointFile << endl;
-    
-    for (auto it=featureTranslate.begin(); it!=featureTranslate.end();++it){
-        checkPointFile<<it->first<<" "<<it->second<<"\t";
+    //The previous check point must be finished before it is replaced, and only one snapshot is kept
+    waitForCheckPoint();
+    CheckPoint* checkPoint = new CheckPoint();
+    getCheckPoint(*checkPoint, episode, totalNumberFrames, delta);
+    if(deltaCheckPoints > 0){
+        string finishedCheckPointName = checkPointName+kind+"-Frames"+to_string(saveThreshold)+"-finished"+extension;
+        if(delta){
+            lastDeltaCheckPoint = finishedCheckPointName;
+            deltasSinceFull++;
+        }else{
+            fullGroupSizes = checkPoint->groupSizes;
+            fullWeights = checkPoint->weights;
+            fullTotalNumberFrames = totalNumberFrames;
+            fullThreshold = saveThreshold;
+            lastFullCheckPoint = finishedCheckPointName;
+            lastDeltaCheckPoint = "";
+            deltasSinceFull = 0;
+        }
     }
-    checkPointFile<<endl;
-    checkPointFile.close();
-    
-    string previousVersionCheckPoint = checkPointName+"-checkPoint-Frames"+to_string(saveThreshold-saveWeightsEveryXFrames)+"-finished.txt";
-    if((saveThreshold-saveWeightsEveryXFrames)%50000000 != 0){
-    	remove(previousVersionCheckPoint.c_str());
+    if(asyncCheckPoint){
+        checkPointThread = std::thread(&SarsaLearner::writeCheckPoint, this, checkPoint, currentCheckPointName, previousVersions);
+    }else{
+        writeCheckPoint(checkPoint, currentCheckPointName, previousVersions);
+    }
+}
+
+void SarsaLearner::writeCheckPoint(CheckPoint* checkPoint, string currentCheckPointName, vector<string> previousVersions){
+    CheckPointIO::sortTranslations(*checkPoint);
+    bool saved;
+    if(checkPoint->isDelta){
+        saved = CheckPointIO::saveDelta(currentCheckPointName, *checkPoint, compressionLevel);
+    }else if(checkPointFormat == 1){
+        saved = CheckPointIO::saveBinary(currentCheckPointName, *checkPoint, compressionLevel);
+    }else{
+        saved = CheckPointIO::saveText(currentCheckPointName, *checkPoint, compressionLevel);
+    }
+    delete checkPoint;
+    if(!saved){
+        printf("Unable to write the check point %s.\n", currentCheckPointName.c_str());
+        return;
     }
+    
+    for(unsigned int i = 0; i < previousVersions.size(); i++){
+        remove(previousVersions[i].c_str());
+    }   
     string oldCheckPointName = currentCheckPointName;
     currentCheckPointName.replace(currentCheckPointName.end()-11,currentCheckPointName.end()-4,"finished");
     rename(oldCheckPointName.c_str(),currentCheckPointName.c_str());
-    
 }
 
-void SarsaLearner::loadCheckPoint(ifstream& checkPointToLoad){
-    checkPointToLoad >> (*agentRand);
-    checkPointToLoad >> totalNumberFrames;
-    while (totalNumberFrames<1000){
-        checkPointToLoad >> totalNumberFrames;
+void SarsaLearner::waitForCheckPoint(){
+    if(checkPointThread.joinable()){
+        checkPointThread.join();
     }
-    checkPointToLoad >> episodePassed;
-    checkPointToLoad >> firstReward;
-    checkPointToLoad >> maxFeatVectorNorm;
+}
+
+void SarsaLearner::getCheckPoint(CheckPoint& checkPoint, int episode, int totalNumberFrames, bool delta){
+    ostringstream randomState;
+    randomState<<(*agentRand);
+    checkPoint.randomState = randomState.str();
+    checkPoint.totalNumberFrames = totalNumberFrames;
+    checkPoint.episode = episode;
+    checkPoint.firstReward = firstReward;
+    checkPoint.maxFeatVectorNorm = maxFeatVectorNorm;
+    checkPoint.numActions = numActions;
+    long long fullNumGroups = 0;
+    checkPoint.isDelta = delta;
+    if(delta){
+        fullNumGroups = fullGroupSizes.size();
+        checkPoint.baseTotalNumberFrames = fullTotalNumberFrames;
+        checkPoint.baseNumGroups = fullNumGroups;
+        checkPoint.deltaNumGroups = numGroups;
+    }
+    checkPoint.groupIndices.clear();
+    checkPoint.groupSizes.clear();
+    checkPoint.weights.clear();
+    if(!delta){
+        checkPoint.groupSizes.reserve(numGroups);
+        checkPoint.weights.reserve(numGroups * numActions);
+    }
+    vector<float> groupWeights(numActions);
+    for (long long groupIndex=0; groupIndex<numGroups;++groupIndex){
+        if (w.isGroupMajor()){
+            memcpy(&groupWeights[0], w.getGroup(groupIndex), numActions * sizeof(float));
+        }else{
+            for (int a=0; a<numActions;a++){
+                groupWeights[a] = w(a,groupIndex);
+            }
+        }
+        if (delta && groupIndex < fullNumGroups && groups[groupIndex].numFeatures == fullGroupSizes[groupIndex]
+            && memcmp(&groupWeights[0], &fullWeights[groupIndex * numActions], numActions * sizeof(float)) == 0){
+            continue;
+        }
+        if (delta){
+            checkPoint.groupIndices.push_back(groupIndex);
+        }
+        checkPoint.groupSizes.push_back(groups[groupIndex].numFeatures);
+        checkPoint.weights.insert(checkPoint.weights.end(), groupWeights.begin(), groupWeights.end());
+    }
+    //They are sorted by whoever writes the check point. Features are only moved to new groups, so
+    //the translations to the groups of the full check point did not change
+    checkPoint.translationFeatures.clear();
+    checkPoint.translationGroups.clear();
+    if(!delta){
+        checkPoint.translationFeatures.reserve(featureTranslate.size());
+        checkPoint.translationGroups.reserve(featureTranslate.size());
+    }
+    for (size_t slot=0; slot<featureTranslate.getCapacity();++slot){
+        if (featureTranslate.isOccupied(slot) && featureTranslate.getGroup(slot) > fullNumGroups){
+            checkPoint.translationFeatures.push_back(featureTranslate.getFeature(slot));
+            checkPoint.translationGroups.push_back(featureTranslate.getGroup(slot));
+        }
+    }
+}
+
+void SarsaLearner::loadCheckPoint(const CheckPoint& checkPoint){
+    istringstream randomState(checkPoint.randomState);
+    randomState >> (*agentRand);
+    totalNumberFrames = checkPoint.totalNumberFrames;
+    episodePassed = checkPoint.episode;
+    firstReward = checkPoint.firstReward;
+    maxFeatVectorNorm = checkPoint.maxFeatVectorNorm;
     learningRate = alpha / float(maxFeatVectorNorm);
-    checkPointToLoad >> numGroups;
-    long long numberOfFeaturesSeen;
-    checkPointToLoad >> numberOfFeaturesSeen;
-    for (unsigned long long index=0;index<numGroups;++index){
+    numGroups = checkPoint.getNumGroups();
+    for (long long index=0;index<numGroups;++index){
         Group agroup;
-        agroup.numFeatures = 0;
+        agroup.numFeatures = checkPoint.groupSizes[index];
         agroup.features.clear();
         groups.push_back(agroup);
     }
-    for (unsigned a =0;a<w.size();a++){
-        w[a].resize(numGroups,0.00);
-        e[a].resize(numGroups,0.00);
+    w.resize(numGroups);
+    e.resize(numGroups);
+    if(lazyTraces){
+        eStep.resize(numGroups);
     }
-    int action;
-    float weight;
-    int numNonZeroWeights;
-    for (unsigned long long groupIndex=0; groupIndex<numGroups;++groupIndex){
-        checkPointToLoad >> numNonZeroWeights;
-        for (unsigned int i=0; i<numNonZeroWeights;++i){
-            checkPointToLoad >> action; checkPointToLoad >> weight;
-            w[action][groupIndex] = weight;
+    for (long long groupIndex=0; groupIndex<numGroups;++groupIndex){
+        const float* groupWeights = &checkPoint.weights[groupIndex * numActions];
+        for (int a=0; a<numActions;a++){
+            w(a,groupIndex) = groupWeights[a];
         }
     }
     
-    long long featureIndex;
-    long long featureToGroup;
-    while (checkPointToLoad >> featureIndex && checkPointToLoad >> featureToGroup){
-        featureTranslate[featureIndex] = featureToGroup;
-        groups[featureToGroup-1].numFeatures+=1;
+    featureTranslate.reserve(checkPoint.translationFeatures.size());
+    for (size_t i=0; i<checkPoint.translationFeatures.size();++i){
+        featureTranslate.set(checkPoint.translationFeatures[i], checkPoint.translationGroups[i]);
     }
-    checkPointToLoad.close();
 }
 
 void SarsaLearner::learnPolicy(ALEInterface& ale, Features *features){
@@ -280,10 +640,16 @@ void SarsaLearner::learnPolicy(ALEInterface& ale, Features *features){
     
     long long trueFeatureSize = 0;
     long long trueFnextSize = 0;
+    int gameOver;
+    
+    std::thread extractionThread;
+    if(pipelinedExtraction){
+        extractionThread = std::thread(&SarsaLearner::extractFeatures, this, std::ref(ale), features);
+    }
     
     //Repeat (for each episode):
     //This is going to be interrupted by the ALE code since I set max_num_frames beforehand
-    for(int episode = episodePassed+1; totalNumberFrames < totalNumberOfFramesToLearn; episode++){
+    for(int episode = episodePassed+1; shared->totalNumberFrames < totalNumberOfFramesToLearn; episode++){
         //random no-op
         unsigned int noOpNum = 0;
         if (randomNoOp){
@@ -294,26 +660,26 @@ void SarsaLearner::learnPolicy(ALEInterface& ale, Features *features){
         }
         
         //We have to clean the traces every episode:
-        for(unsigned int a = 0; a < nonZeroElig.size(); a++){
-            for(unsigned long long i = 0; i < nonZeroElig[a].size(); i++){
-                long long idx = nonZeroElig[a][i];
-                e[a][idx] = 0.0;
-            }
-            nonZeroElig[a].clear();
-        }
+        clearTraces();
         
         F.clear();
         features->getActiveFeaturesIndices(ale.getScreen(), ale.getRAM(), F);
         trueFeatureSize = F.size();
-        groupFeatures(F);
+        lockWeights(0);
+        groupActiveFeatures(F);
         updateQValues(F, Q);
         
         currentAction = epsilonGreedy(Q,episode);
         gettimeofday(&tvBegin, NULL);
         int lives = ale.lives();
+        gameOver = ale.game_over();
+        if(pipelinedExtraction && !gameOver){
+            actionRing.getWriteSlot() = currentAction;
+            actionRing.push();
+        }
         //Repeat(for each step of episode) until game is over:
         //This also stops when the maximum number of steps per episode is reached
-        while(!ale.game_over()){
+        while(!gameOver){
             reward.clear();
             reward.push_back(0.0);
             reward.push_back(0.0);
@@ -321,19 +687,40 @@ void SarsaLearner::learnPolicy(ALEInterface& ale, Features *features){
             updateReplTrace(currentAction, F);
             
             sanityCheck();
-            //Take action, observe reward and next state:
-            act(ale, currentAction, reward);
+            //The other actors may change the groups while this one acts
+            unlockWeights();
+            if(pipelinedExtraction){
+                //The extraction thread already acted and extracted the features
+                Transition& transition = transitionRing.front();
+                reward.swap(transition.reward);
+                gameOver = transition.gameOver;
+                Fnext.swap(transition.features);
+                transitionRing.pop();
+            }else{
+                //Take action, observe reward and next state:
+                act(ale, currentAction, reward);
+                gameOver = ale.game_over();
+                if(!gameOver){
+                    //Obtain active features in the new state:
+                    Fnext.clear();
+                    features->getActiveFeaturesIndices(ale.getScreen(), ale.getRAM(), Fnext);
+                }
+            }
             cumReward  += reward[1];
-            if(!ale.game_over()){
-                //Obtain active features in the new state:
-                Fnext.clear();
-                features->getActiveFeaturesIndices(ale.getScreen(), ale.getRAM(), Fnext);
+            if(!gameOver){
                 trueFnextSize = Fnext.size();
-                groupFeatures(Fnext);
+                lockWeights(0);
+                groupActiveFeatures(Fnext);
                 updateQValues(Fnext, Qnext);     //Update Q-values for the new active features
                 nextAction = epsilonGreedy(Qnext,episode);
+                if(pipelinedExtraction){
+                    //The next action is taken while the weights are updated
+                    actionRing.getWriteSlot() = nextAction;
+                    actionRing.push();
+                }
             }
             else{
+                lockWeights(0);
                 nextAction = 0;
                 for(unsigned int i = 0; i < Qnext.size(); i++){
                     Qnext[i] = 0;
@@ -348,90 +735,59 @@ void SarsaLearner::learnPolicy(ALEInterface& ale, Features *features){
             delta = reward[0] + gamma * Qnext[nextAction] - Q[currentAction];
             
             //Update weights vector:
-            for(unsigned int a = 0; a < nonZeroElig.size(); a++){
-                for(unsigned int i = 0; i < nonZeroElig[a].size(); i++){
-                    long long idx = nonZeroElig[a][i];
-                    w[a][idx] = w[a][idx] + learningRate * delta * e[a][idx];
-                }
-            }
+            updateWeights();
             F = Fnext;
             trueFeatureSize = trueFnextSize;
             currentAction = nextAction;
         }
+        unlockWeights();
         gettimeofday(&tvEnd, NULL);
         timeval_subtract(&tvDiff, &tvEnd, &tvBegin);
         elapsedTime = double(tvDiff.tv_sec) + double(tvDiff.tv_usec)/1000000.0;
         
         double fps = double(ale.getEpisodeFrameNumber())/elapsedTime;
-        printf("episode: %d,\t%.0f points,\tavg. return: %.1f,\t%d frames,\t%.0f fps\n",
-               episode, cumReward - prevCumReward, (double)cumReward/(episode),
+        string actorName = hogwild ? "actor " + to_string(actor) + ", " : "";
+        printf("%sepisode: %d,\t%.0f points,\tavg. return: %.1f,\t%d frames,\t%.0f fps\n",
+               actorName.c_str(), episode, cumReward - prevCumReward, (double)cumReward/(episode),
                ale.getEpisodeFrameNumber(), fps);
         episodeResults.push_back(cumReward-prevCumReward);
         episodeFrames.push_back(ale.getEpisodeFrameNumber());
         episodeFps.push_back(fps);
-        totalNumberFrames += ale.getEpisodeFrameNumber()-noOpNum*numStepsPerAction;
+        totalNumberFrames = shared->totalNumberFrames += ale.getEpisodeFrameNumber()-noOpNum*numStepsPerAction;
         prevCumReward = cumReward;
         features->clearCash();
         ale.reset_game();
-        if(toSaveCheckPoint && totalNumberFrames>saveThreshold){
+        if(toSaveCheckPoint && actor == 0 && totalNumberFrames>saveThreshold){
+            lockWeights(1);
             saveCheckPoint(episode,totalNumberFrames,episodeResults,saveWeightsEveryXFrames,episodeFrames,episodeFps);
+            unlockWeights();
             saveThreshold+=saveWeightsEveryXFrames;
         }
     }
+    if(pipelinedExtraction){
+        actionRing.getWriteSlot() = -1;
+        actionRing.push();
+        extractionThread.join();
+    }
+}
+
+void SarsaLearner::freezeGroups(){
+    shared->frozenTranslate.build(featureTranslate);
+}
+
+void SarsaLearner::releaseFrozenGroups(){
+    shared->frozenTranslate.clear();
 }
 
 void SarsaLearner::evaluatePolicy(ALEInterface& ale, Features *features){
-    double reward = 0;
-    double cumReward = 0;
-    double prevCumReward = 0;
-    struct timeval tvBegin, tvEnd, tvDiff;
-    double elapsedTime;
-    
-    std::string oldName = checkPointName+"-Result-writing.txt";
-    std::string newName = checkPointName+"-Result-finished.txt";
-    std::ofstream resultFile;
-    resultFile.open(oldName.c_str());
-    
-    //Repeat (for each episode):
-    for(int episode = 1; episode < numEpisodesEval; episode++){
-        //Repeat(for each step of episode) until game is over:
-        gettimeofday(&tvBegin, NULL);
-        //random no-op
-        unsigned int noOpNum;
-        if (randomNoOp){
-            noOpNum = (*agentRand)()%(noOpMax)+1;
-            for (int i=0;i<noOpNum;++i){
-                ale.act(actions[0]);
-            }
-        }
-        
-        for(int step = 0; !ale.game_over() && step < episodeLength; step++){
-            //Get state and features active on that state:
-            F.clear();
-            features->getActiveFeaturesIndices(ale.getScreen(), ale.getRAM(), F);
-            groupFeatures(F);
-            updateQValues(F, Q);       //Update Q-values for each possible action
-            currentAction = epsilonGreedy(Q);
-            //Take action, observe reward and next state:
-            reward = ale.act(actions[currentAction]);
-            cumReward  += reward;
-        }
-        gettimeofday(&tvEnd, NULL);
-        timeval_subtract(&tvDiff, &tvEnd, &tvBegin);
-        elapsedTime = double(tvDiff.tv_sec) + double(tvDiff.tv_usec)/1000000.0;
-        double fps = double(ale.getEpisodeFrameNumber())/elapsedTime;
-        
-        resultFile<<"Episode "<<episode<<": "<<cumReward-prevCumReward<<std::endl;
-        printf("episode: %d,\t%.0f points,\tavg. return: %.1f,\t%d frames,\t%.0f fps\n",
-               episode, (cumReward-prevCumReward), (double)cumReward/(episode), ale.getEpisodeFrameNumber(), fps);
-        features->clearCash();
-        ale.reset_game();
-        prevCumReward = cumReward;
-    }
-    resultFile<<"Average: "<<(double)cumReward/numEpisodesEval<<std::endl;
-    resultFile.close();
-    rename(oldName.c_str(),newName.c_str());
-    
+    //The episodes are the ones of a single worker of the parallel evaluation, so they are seeded
+    //the same way and the scores do not depend on NUM_EVAL_THREADS
+    freezeGroups();
+    atomic<int> nextEpisode(1);
+    vector<double> episodeScores(numEpisodesEval, 0);
+    evaluateEpisodes(ale, features, nextEpisode, episodeScores);
+    releaseFrozenGroups();
+    saveEvaluationResults(episodeScores);
 }
 
 void SarsaLearner::groupFeatures(vector<long long>& activeFeatures){
@@ -440,9 +796,10 @@ void SarsaLearner::groupFeatures(vector<long long>& activeFeatures){
     int newGroup = 0;
     for (unsigned long long i = 0; i <activeFeatures.size();++i){
         long long featureIndex = activeFeatures[i];
-        if (featureTranslate[featureIndex] == 0){
+        int& featureGroup = featureTranslate.findOrInsert(featureIndex);
+        if (featureGroup == 0){
             if (newGroup){
-                featureTranslate[featureIndex] = numGroups;
+                featureGroup = numGroups;
                 groups[numGroups-1].numFeatures+=1;
             }else{
                 newGroup = 1;
@@ -450,15 +807,16 @@ void SarsaLearner::groupFeatures(vector<long long>& activeFeatures){
                 agroup.numFeatures = 1;
                 agroup.features.clear();
                 groups.push_back(agroup);
-                for (unsigned int action=0;action<w.size();++action){
-                    w[action].push_back(0.0);
-                    e[action].push_back(0.0);
+                w.addGroup();
+                e.addGroup();
+                if(lazyTraces){
+                    eStep.addGroup();
                 }
                 ++numGroups;
-                featureTranslate[featureIndex] = numGroups;
+                featureGroup = numGroups;
             }
         }else{
-            long long groupIndex = featureTranslate[featureIndex]-1;
+            long long groupIndex = featureGroup-1;
             auto it = &groups[groupIndex].features;
             if (it->size() == 0){
                 activeGroupIndices.push_back(groupIndex);
@@ -481,14 +839,20 @@ void SarsaLearner::groupFeatures(vector<long long>& activeFeatures){
             groups.push_back(agroup);
             ++numGroups;
             for (unsigned long long i =0; i<groups[groupIndex].features.size();++i){
-                featureTranslate[groups[groupIndex].features[i]] = numGroups;
+                featureTranslate.set(groups[groupIndex].features[i], numGroups);
             }
             activeFeatures.push_back(numGroups-1);
-            for (unsigned a = 0;a<w.size();++a){
-                w[a].push_back(w[a][groupIndex]);
-                e[a].push_back(e[a][groupIndex]);
-                if (e[a].back()>=traceThreshold ){
+            w.addGroupCopy(groupIndex);
+            e.addGroupCopy(groupIndex);
+            if(lazyTraces){
+                eStep.addGroupCopy(groupIndex);
+            }
+            for (unsigned a = 0;a<numActions;++a){
+                if (getTrace(a,numGroups-1)>=traceThreshold ){
                     nonZeroElig[a].push_back(numGroups-1);
+                }else{
+                    //A zero trace is never in nonZeroElig
+                    e(a,numGroups-1) = 0;
                 }
             }
             groups[groupIndex].numFeatures = groups[groupIndex].numFeatures - groups[groupIndex].features.size();
@@ -500,14 +864,127 @@ void SarsaLearner::groupFeatures(vector<long long>& activeFeatures){
     }
 }
 
+void SarsaLearner::evaluateEpisodes(ALEInterface& ale, Features *features, atomic<int>& nextEpisode, vector<double>& episodeScores){
+    struct timeval tvBegin, tvEnd, tvDiff;
+    double elapsedTime;
+    
+    for(int episode = nextEpisode++; episode < numEpisodesEval; episode = nextEpisode++){
+        seed_seq episodeSeed{evaluationSeed, episode};
+        agentRand->seed(episodeSeed);
+        double cumReward = 0;
+        gettimeofday(&tvBegin, NULL);
+        //random no-op
+        if (randomNoOp){
+            unsigned int noOpNum = (*agentRand)()%(noOpMax)+1;
+            for (int i=0;i<noOpNum;++i){
+                ale.act(actions[0]);
+            }
+        }
+        for(int step = 0; !ale.game_over() && step < episodeLength; step++){
+            //Get state and features active on that state:
+            F.clear();
+            features->getActiveFeaturesIndices(ale.getScreen(), ale.getRAM(), F);
+            updateFrozenQValues(F, Q);
+            currentAction = epsilonGreedy(Q);
+            //Take action, observe reward and next state:
+            cumReward += ale.act(actions[currentAction]);
+        }
+        gettimeofday(&tvEnd, NULL);
+        timeval_subtract(&tvDiff, &tvEnd, &tvBegin);
+        elapsedTime = double(tvDiff.tv_sec) + double(tvDiff.tv_usec)/1000000.0;
+        double fps = double(ale.getEpisodeFrameNumber())/elapsedTime;
+        
+        episodeScores[episode] = cumReward;
+        printf("worker %d, episode: %d,\t%.0f points,\t%d frames,\t%.0f fps\n",
+               actor, episode, cumReward, ale.getEpisodeFrameNumber(), fps);
+        features->clearCash();
+        ale.reset_game();
+    }
+}
+
+void SarsaLearner::saveEvaluationResults(vector<double>& episodeScores){
+    std::string oldName = checkPointName+"-Result-writing.txt";
+    std::string newName = checkPointName+"-Result-finished.txt";
+    std::ofstream resultFile;
+    resultFile.open(oldName.c_str());
+    
+    //The same lines evaluatePolicy writes, in the order of the episodes
+    double cumReward = 0;
+    for(int episode = 1; episode < numEpisodesEval; episode++){
+        resultFile<<"Episode "<<episode<<": "<<episodeScores[episode]<<std::endl;
+        cumReward += episodeScores[episode];
+    }
+    resultFile<<"Average: "<<(double)cumReward/numEpisodesEval<<std::endl;
+    resultFile.close();
+    rename(oldName.c_str(),newName.c_str());
+}
+
+bool SarsaLearner::findExistingGroups(vector<long long>& activeFeatures){
+    if(activeGroupCount.size() < numGroups){
+        activeGroupCount.resize(numGroups, 0);
+    }
+    vector<long long> activeGroupIndices;
+    bool found = true;
+    for (unsigned long long i = 0; i < activeFeatures.size(); ++i){
+        int featureGroup = featureTranslate.get(activeFeatures[i]);
+        if (featureGroup == 0){
+            found = false;
+            break;
+        }
+        long long groupIndex = featureGroup-1;
+        if (activeGroupCount[groupIndex] == 0){
+            activeGroupIndices.push_back(groupIndex);
+        }
+        activeGroupCount[groupIndex]++;
+    }
+    //A group with only some of its features active would be split
+    for (unsigned long long index = 0; index < activeGroupIndices.size(); ++index){
+        long long groupIndex = activeGroupIndices[index];
+        if (activeGroupCount[groupIndex] != groups[groupIndex].numFeatures){
+            found = false;
+        }
+        activeGroupCount[groupIndex] = 0;
+    }
+    if (found){
+        activeFeatures.swap(activeGroupIndices);
+    }
+    return found;
+}
+
+void SarsaLearner::groupActiveFeatures(vector<long long>& activeFeatures){
+    if(!hogwild){
+        groupFeatures(activeFeatures);
+        return;
+    }
+    if(!findExistingGroups(activeFeatures)){
+        unlockWeights();
+        lockWeights(1);
+        //groupFeatures adds the new groups to the traces, so they must have all groups before
+        growTraces();
+        groupFeatures(activeFeatures);
+        unlockWeights();
+        lockWeights(0);
+    }
+    growTraces();
+}
+
+void SarsaLearner::growTraces(){
+    if(e.getNumGroups() < numGroups){
+        e.resize(numGroups);
+        if(lazyTraces){
+            eStep.resize(numGroups);
+        }
+    }
+}
+
 void SarsaLearner::saveWeightsToFile(string suffix){
-    std::ofstream weightsFile ((nameWeightsFile + suffix).c_str());
+    GzOutputStream weightsFile(nameWeightsFile + suffix, compressionLevel);
     if(weightsFile.is_open()){
-        weightsFile << w.size() << " " << w[0].size() << std::endl;
-        for(unsigned int i = 0; i < w.size(); i++){
-            for(unsigned int j = 0; j < w[i].size(); j++){
-                if(w[i][j] != 0){
-                    weightsFile << i << " " << j << " " << w[i][j] << std::endl;
+        weightsFile << w.getNumActions() << " " << w.getNumGroups() << std::endl;
+        for(unsigned int i = 0; i < w.getNumActions(); i++){
+            for(unsigned int j = 0; j < w.getNumGroups(); j++){
+                if(w(i,j) != 0){
+                    weightsFile << i << " " << j << " " << w(i,j) << std::endl;
                 }
             }
         }
@@ -524,13 +1001,13 @@ void SarsaLearner::loadWeights(){
     int i, j;
     double value;
     
-    std::ifstream weightsFile (pathWeightsFileToLoad.c_str());
+    GzInputStream weightsFile(pathWeightsFileToLoad);
     
     weightsFile >> nActions >> nFeatures;
     assert(nActions == numActions);
     assert(nFeatures == numFeatures);
     
     while(weightsFile >> i >> j >> value){
-        w[i][j] = value;
+        w(i,j) = value;
     }
 }
@@ -0,0 +1,102 @@
+/****************************************************************************************
+** Benchmark of the two layouts of WeightTable (WEIGHTS_LAYOUT in the config file). It
+** reproduces what SarsaLearner does with the weights and traces at every step, on random
+** groups: the creation of new groups, the Q-values of the active groups and the update of
+** the weights of the groups with a non-zero trace. It does not need ALE.
+**
+** Usage: ./benchWeightLayout [numGroups] [numActiveGroups] [numSteps] [numActions]
+**
+** Author: Marlos C. Machado
+***************************************************************************************/
+
+#ifndef WEIGHT_TABLE_H
+#define WEIGHT_TABLE_H
+#include "common/WeightTable.hpp"
+#endif
+#ifndef TIMER_H
+#define TIMER_H
+#include "common/Timer.hpp"
+#endif
+#include <stdio.h>
+#include <random>
+#include <vector>
+using namespace std;
+
+static double elapsedSeconds(struct timeval& begin){
+    struct timeval end, diff;
+    gettimeofday(&end, NULL);
+    timeval_subtract(&diff, &end, &begin);
+    return double(diff.tv_sec) + double(diff.tv_usec)/1000000.0;
+}
+
+int main(int argc, char** argv){
+    long long numGroups = argc > 1 ? atoll(argv[1]) : 1000000;
+    int numActive       = argc > 2 ? atoi(argv[2]) : 1000;
+    int numSteps        = argc > 3 ? atoi(argv[3]) : 20000;
+    int numActions      = argc > 4 ? atoi(argv[4]) : 18;
+    printf("%lld groups, %d active groups per step, %d steps, %d actions\n", numGroups, numActive, numSteps, numActions);
+
+    vector<float> multipliers(numGroups);
+    std::mt19937 generator(1);
+    for (long long g = 0; g < numGroups; g++){
+        multipliers[g] = 1 + generator() % 4;
+    }
+    //The same random steps are used for both layouts
+    vector<vector<long long> > activeGroups(64);
+    for (int s = 0; s < activeGroups.size(); s++){
+        for (int i = 0; i < numActive; i++){
+            activeGroups[s].push_back(generator() % numGroups);
+        }
+    }
+
+    double checksum[2];
+    for (int layout = 0; layout < 2; layout++){
+        WeightTable w, e;
+        struct timeval begin;
+
+        //Groups are created one at a time, half of them copying an existing group, as in groupFeatures
+        gettimeofday(&begin, NULL);
+        w.init(numActions, layout);
+        e.init(numActions, layout);
+        for (long long g = 0; g < numGroups; g++){
+            if (g > 0 && g % 2 == 0){
+                w.addGroupCopy(g / 2);
+                e.addGroupCopy(g / 2);
+            }else{
+                w.addGroup();
+                e.addGroup();
+            }
+            w(g % numActions, g) = 0.001f * (g % 1000);
+        }
+        double growTime = elapsedSeconds(begin);
+
+        //Q-values of the active groups, as in updateQValues
+        vector<float> Q(numActions);
+        double sum = 0;
+        gettimeofday(&begin, NULL);
+        for (int s = 0; s < numSteps; s++){
+            w.sumGroups(activeGroups[s % activeGroups.size()], [&multipliers](long long group){ return multipliers[group]; }, &Q[0]);
+            sum += Q[s % numActions];
+        }
+        double qTime = elapsedSeconds(begin);
+
+        //Weight update of the groups with a non-zero trace, one action at a time as in learnPolicy
+        gettimeofday(&begin, NULL);
+        for (int s = 0; s < numSteps; s++){
+            vector<long long>& nonZero = activeGroups[s % activeGroups.size()];
+            e(s % numActions, nonZero[0]) = 1;
+            for (int a = 0; a < numActions; a++){
+                for (int i = 0; i < nonZero.size(); i++){
+                    w(a, nonZero[i]) = w(a, nonZero[i]) + 0.01f * e(a, nonZero[i]);
+                }
+            }
+        }
+        double updateTime = elapsedSeconds(begin);
+        checksum[layout] = sum + w(0, activeGroups[0][0]);
+
+        printf("%s: groups created in %.3f s, Q-values %.2f us/step, weight update %.2f us/step\n",
+               layout ? "group-major " : "action-major", growTime, 1e6 * qTime / numSteps, 1e6 * updateTime / numSteps);
+    }
+    printf("Q-values are %s in both layouts\n", checksum[0] == checksum[1] ? "equal" : "DIFFERENT");
+    return 0;
+}
@@ -0,0 +1,515 @@
+/****************************************************************************************
+ ** Contents of a check point of SarsaLearner and the functions that save and load it.
+ **
+ ** REMARKS: - All methods' high-level comments are in the .hpp file.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include "CheckPoint.hpp"
+#endif
+#ifndef GZ_STREAM_H
+#define GZ_STREAM_H
+#include "GzStream.hpp"
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <sstream>
+#include <random>
+#include <zlib.h>
+
+static const char MAGIC[8] = {'B','P','R','O','C','K','P','T'};
+static const char DELTA_MAGIC[8] = {'B','P','R','O','D','L','T','A'};
+
+static bool isLittleEndianHost(){
+    uint16_t one = 1;
+    return *(unsigned char*) &one == 1;
+}
+
+static void reverseBytes(unsigned char* value, size_t size){
+    std::reverse(value, value + size);
+}
+
+/**
+ * Opens a file to be written with the given compression level, see GzStream.hpp.
+ */
+static gzFile openForWriting(const std::string& fileName, int compressionLevel){
+    std::string mode = compressionLevel == 0 ? "wbT" : "wb" + std::to_string(compressionLevel);
+    gzFile file = gzopen(fileName.c_str(), mode.c_str());
+    if (file != NULL){
+        gzbuffer(file, 1 << 17);
+    }
+    return file;
+}
+
+/**
+ * Writes values in little-endian and keeps the CRC-32 of everything written.
+ */
+class BinaryWriter{
+private:
+    gzFile file;
+    uLong crc;
+    bool ok;
+    std::vector<unsigned char> swapped;
+
+    void writeBytes(const void* bytes, size_t size){
+        if (size == 0){
+            return;
+        }
+        crc = crc32(crc, (const Bytef*) bytes, size);
+        //gzwrite takes at most an unsigned int at a time
+        for (size_t written = 0; ok && written < size; written += 1 << 30){
+            unsigned int chunk = std::min(size - written, (size_t) 1 << 30);
+            ok = gzwrite(file, (const char*) bytes + written, chunk) == (int) chunk;
+        }
+    }
+
+public:
+    BinaryWriter(gzFile file) : file(file), crc(crc32(0L, Z_NULL, 0)), ok(file != NULL){}
+
+    template<class T>
+    void writeArray(const T* values, size_t numValues){
+        if (isLittleEndianHost()){
+            writeBytes(values, numValues * sizeof(T));
+            return;
+        }
+        swapped.resize(numValues * sizeof(T));
+        memcpy(&swapped[0], values, numValues * sizeof(T));
+        for (size_t i = 0; i < numValues; i++){
+            reverseBytes(&swapped[i * sizeof(T)], sizeof(T));
+        }
+        writeBytes(&swapped[0], swapped.size());
+    }
+    template<class T>
+    void write(T value){
+        writeArray(&value, 1);
+    }
+    void writeString(const std::string& value){
+        write<uint32_t>(value.size());
+        writeBytes(value.data(), value.size());
+    }
+    /**
+     * Writes the checksum of everything written so far.
+     */
+    void writeChecksum(){
+        write<uint32_t>(crc);
+    }
+    bool isOk(){
+        return ok;
+    }
+};
+
+/**
+ * Reads little-endian values from a file loaded at once.
+ */
+class BinaryReader{
+private:
+    const std::vector<unsigned char>& data;
+    size_t position;
+    bool ok;
+
+public:
+    BinaryReader(const std::vector<unsigned char>& data) : data(data), position(0), ok(true){}
+
+    template<class T>
+    void readArray(T* values, size_t numValues){
+        size_t size = numValues * sizeof(T);
+        if (!ok || size > data.size() - position){
+            ok = false;
+            return;
+        }
+        if (size > 0){
+            memcpy(values, &data[position], size);
+        }
+        position += size;
+        if (!isLittleEndianHost()){
+            for (size_t i = 0; i < numValues; i++){
+                reverseBytes((unsigned char*) &values[i], sizeof(T));
+            }
+        }
+    }
+    template<class T>
+    T read(){
+        T value = 0;
+        readArray(&value, 1);
+        return value;
+    }
+    template<class T>
+    void readVector(std::vector<T>& values, long long numValues){
+        //A corrupted count must not allocate more than the file has
+        if (numValues < 0 || (size_t) numValues > (data.size() - position) / sizeof(T)){
+            ok = false;
+            return;
+        }
+        values.resize(numValues);
+        readArray(values.empty() ? NULL : &values[0], values.size());
+    }
+    std::string readString(){
+        uint32_t size = read<uint32_t>();
+        if (!ok || size > data.size() - position){
+            ok = false;
+            return "";
+        }
+        std::string value((const char*) &data[position], size);
+        position += size;
+        return value;
+    }
+    bool isOk(){
+        return ok;
+    }
+};
+
+/**
+ * Reads a whole file, decompressing it as it is read if it is compressed.
+ */
+static bool readFile(const std::string& fileName, std::vector<unsigned char>& data){
+    gzFile file = gzopen(fileName.c_str(), "rb");
+    if (file == NULL){
+        return false;
+    }
+    gzbuffer(file, 1 << 17);
+    const size_t chunk = 1 << 20;
+    size_t size = 0;
+    int read;
+    do{
+        if (data.size() - size < chunk){
+            data.resize(std::max(2 * data.size(), size + chunk));
+        }
+        read = gzread(file, &data[size], std::min(data.size() - size, (size_t) 1 << 30));
+        size += read > 0 ? read : 0;
+    }while (read > 0);
+    data.resize(size);
+    //A truncated compressed file is an error of gzread
+    bool ok = read == 0;
+    return gzclose(file) == Z_OK && ok;
+}
+
+/**
+ * Writes what full and delta check points start with, up to the number of actions.
+ */
+static void writeHeader(BinaryWriter& writer, const char* magic, const CheckPoint& checkPoint){
+    writer.writeArray(magic, sizeof(MAGIC));
+    writer.write<uint32_t>(CheckPointIO::VERSION);
+    writer.writeString(checkPoint.randomState);
+    writer.write<int64_t>(checkPoint.totalNumberFrames);
+    writer.write<int64_t>(checkPoint.episode);
+    writer.write<float>(checkPoint.firstReward);
+    writer.write<int64_t>(checkPoint.maxFeatVectorNorm);
+    writer.write<int32_t>(checkPoint.numActions);
+}
+
+static void readHeader(BinaryReader& reader, CheckPoint& checkPoint){
+    checkPoint.randomState = reader.readString();
+    checkPoint.totalNumberFrames = reader.read<int64_t>();
+    checkPoint.episode = reader.read<int64_t>();
+    checkPoint.firstReward = reader.read<float>();
+    checkPoint.maxFeatVectorNorm = reader.read<int64_t>();
+    checkPoint.numActions = reader.read<int32_t>();
+}
+
+/**
+ * Reads a whole binary check point and checks its magic, version and checksum.
+ */
+static bool readVerified(const std::string& fileName, const char* magic, const char* kind, std::vector<unsigned char>& data, std::string& error){
+    if (!readFile(fileName, data)){
+        error = "cannot read " + fileName;
+        return false;
+    }
+    if (data.size() < sizeof(MAGIC) + 2 * sizeof(uint32_t) || memcmp(&data[0], magic, sizeof(MAGIC)) != 0){
+        error = fileName + " is not a " + kind;
+        return false;
+    }
+    BinaryReader reader(data);
+    char fileMagic[sizeof(MAGIC)];
+    reader.readArray(fileMagic, sizeof(MAGIC));
+    unsigned int version = reader.read<uint32_t>();
+    if (version != CheckPointIO::VERSION){
+        error = fileName + " has version " + std::to_string(version) + ", only version " + std::to_string(CheckPointIO::VERSION) + " is supported";
+        return false;
+    }
+    //The checksum is the last 4 bytes
+    size_t checkedSize = data.size() - sizeof(uint32_t);
+    std::vector<unsigned char> checksumBytes(data.begin() + checkedSize, data.end());
+    BinaryReader checksumReader(checksumBytes);
+    if (checksumReader.read<uint32_t>() != (uint32_t) crc32(crc32(0L, Z_NULL, 0), &data[0], checkedSize)){
+        error = fileName + " is corrupted, its checksum is wrong";
+        return false;
+    }
+    return true;
+}
+
+bool CheckPointIO::saveBinary(const std::string& fileName, const CheckPoint& checkPoint, int compressionLevel){
+    gzFile file = openForWriting(fileName, compressionLevel);
+    if (file == NULL){
+        return false;
+    }
+    BinaryWriter writer(file);
+    writeHeader(writer, MAGIC, checkPoint);
+    writer.write<int64_t>(checkPoint.getNumGroups());
+    writer.write<int64_t>(checkPoint.translationFeatures.size());
+    writer.writeArray((const int64_t*) checkPoint.groupSizes.data(), checkPoint.groupSizes.size());
+    writer.writeArray(checkPoint.weights.data(), checkPoint.weights.size());
+    writer.writeArray((const int64_t*) checkPoint.translationFeatures.data(), checkPoint.translationFeatures.size());
+    writer.writeArray((const int32_t*) checkPoint.translationGroups.data(), checkPoint.translationGroups.size());
+    writer.writeChecksum();
+    bool ok = writer.isOk();
+    return gzclose(file) == Z_OK && ok;
+}
+
+bool CheckPointIO::loadBinary(const std::string& fileName, CheckPoint& checkPoint, std::string& error){
+    std::vector<unsigned char> data;
+    if (!readVerified(fileName, MAGIC, "binary check point", data, error)){
+        return false;
+    }
+    BinaryReader reader(data);
+    char magic[sizeof(MAGIC)];
+    reader.readArray(magic, sizeof(MAGIC));
+    reader.read<uint32_t>();
+    readHeader(reader, checkPoint);
+    long long numGroups = reader.read<int64_t>();
+    long long numTranslations = reader.read<int64_t>();
+    reader.readVector(checkPoint.groupSizes, numGroups);
+    reader.readVector(checkPoint.weights, numGroups * checkPoint.numActions);
+    reader.readVector(checkPoint.translationFeatures, numTranslations);
+    reader.readVector(checkPoint.translationGroups, numTranslations);
+    if (!reader.isOk()){
+        error = fileName + " is truncated";
+        return false;
+    }
+    return true;
+}
+
+bool CheckPointIO::saveDelta(const std::string& fileName, const CheckPoint& delta, int compressionLevel){
+    gzFile file = openForWriting(fileName, compressionLevel);
+    if (file == NULL){
+        return false;
+    }
+    BinaryWriter writer(file);
+    writeHeader(writer, DELTA_MAGIC, delta);
+    writer.write<int64_t>(delta.baseTotalNumberFrames);
+    writer.write<int64_t>(delta.baseNumGroups);
+    writer.write<int64_t>(delta.deltaNumGroups);
+    writer.write<int64_t>(delta.groupIndices.size());
+    writer.write<int64_t>(delta.translationFeatures.size());
+    writer.writeArray((const int64_t*) delta.groupIndices.data(), delta.groupIndices.size());
+    writer.writeArray((const int64_t*) delta.groupSizes.data(), delta.groupSizes.size());
+    writer.writeArray(delta.weights.data(), delta.weights.size());
+    writer.writeArray((const int64_t*) delta.translationFeatures.data(), delta.translationFeatures.size());
+    writer.writeArray((const int32_t*) delta.translationGroups.data(), delta.translationGroups.size());
+    writer.writeChecksum();
+    bool ok = writer.isOk();
+    return gzclose(file) == Z_OK && ok;
+}
+
+bool CheckPointIO::loadDelta(const std::string& fileName, CheckPoint& delta, std::string& error){
+    std::vector<unsigned char> data;
+    if (!readVerified(fileName, DELTA_MAGIC, "delta check point", data, error)){
+        return false;
+    }
+    BinaryReader reader(data);
+    char magic[sizeof(MAGIC)];
+    reader.readArray(magic, sizeof(MAGIC));
+    reader.read<uint32_t>();
+    readHeader(reader, delta);
+    delta.isDelta = true;
+    delta.baseTotalNumberFrames = reader.read<int64_t>();
+    delta.baseNumGroups = reader.read<int64_t>();
+    delta.deltaNumGroups = reader.read<int64_t>();
+    long long numRows = reader.read<int64_t>();
+    long long numTranslations = reader.read<int64_t>();
+    reader.readVector(delta.groupIndices, numRows);
+    reader.readVector(delta.groupSizes, numRows);
+    reader.readVector(delta.weights, numRows * delta.numActions);
+    reader.readVector(delta.translationFeatures, numTranslations);
+    reader.readVector(delta.translationGroups, numTranslations);
+    if (!reader.isOk()){
+        error = fileName + " is truncated";
+        return false;
+    }
+    for (size_t row = 0; row < delta.groupIndices.size(); row++){
+        if (delta.groupIndices[row] < 0 || delta.groupIndices[row] >= delta.deltaNumGroups){
+            error = fileName + " has the unknown group " + std::to_string(delta.groupIndices[row]);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CheckPointIO::applyDelta(CheckPoint& checkPoint, const CheckPoint& delta, std::string& error){
+    if (delta.baseTotalNumberFrames != checkPoint.totalNumberFrames || delta.baseNumGroups != checkPoint.getNumGroups()
+        || delta.numActions != checkPoint.numActions || delta.deltaNumGroups < delta.baseNumGroups){
+        error = "the delta was taken after the check point of frame " + std::to_string(delta.baseTotalNumberFrames)
+                + ", this one is of frame " + std::to_string(checkPoint.totalNumberFrames);
+        return false;
+    }
+    int numActions = checkPoint.numActions;
+    checkPoint.groupSizes.resize(delta.deltaNumGroups, 0);
+    checkPoint.weights.resize(delta.deltaNumGroups * numActions, 0);
+    for (size_t row = 0; row < delta.groupIndices.size(); row++){
+        long long groupIndex = delta.groupIndices[row];
+        checkPoint.groupSizes[groupIndex] = delta.groupSizes[row];
+        memcpy(&checkPoint.weights[groupIndex * numActions], &delta.weights[row * numActions], numActions * sizeof(float));
+    }
+
+    //Both are sorted by feature, a feature in both was moved to a new group
+    std::vector<long long> features;
+    std::vector<int> groups;
+    features.reserve(checkPoint.translationFeatures.size() + delta.translationFeatures.size());
+    groups.reserve(features.capacity());
+    size_t i = 0, j = 0;
+    while (i < checkPoint.translationFeatures.size() || j < delta.translationFeatures.size()){
+        if (j == delta.translationFeatures.size() || (i < checkPoint.translationFeatures.size() && checkPoint.translationFeatures[i] < delta.translationFeatures[j])){
+            features.push_back(checkPoint.translationFeatures[i]);
+            groups.push_back(checkPoint.translationGroups[i]);
+            i++;
+        }else{
+            if (i < checkPoint.translationFeatures.size() && checkPoint.translationFeatures[i] == delta.translationFeatures[j]){
+                i++;
+            }
+            features.push_back(delta.translationFeatures[j]);
+            groups.push_back(delta.translationGroups[j]);
+            j++;
+        }
+    }
+    checkPoint.translationFeatures.swap(features);
+    checkPoint.translationGroups.swap(groups);
+
+    checkPoint.randomState = delta.randomState;
+    checkPoint.totalNumberFrames = delta.totalNumberFrames;
+    checkPoint.episode = delta.episode;
+    checkPoint.firstReward = delta.firstReward;
+    checkPoint.maxFeatVectorNorm = delta.maxFeatVectorNorm;
+    return true;
+}
+
+bool CheckPointIO::saveText(const std::string& fileName, const CheckPoint& checkPoint, int compressionLevel){
+    GzOutputStream checkPointFile(fileName, compressionLevel);
+    if (!checkPointFile.is_open()){
+        return false;
+    }
+    checkPointFile << checkPoint.randomState << std::endl;
+    checkPointFile << checkPoint.totalNumberFrames << std::endl;
+    checkPointFile << checkPoint.episode << std::endl;
+    checkPointFile << checkPoint.firstReward << std::endl;
+    checkPointFile << checkPoint.maxFeatVectorNorm << std::endl;
+    checkPointFile << checkPoint.getNumGroups() << std::endl;
+    checkPointFile << checkPoint.translationFeatures.size() << std::endl;
+    int numActions = checkPoint.numActions;
+    for (long long groupIndex = 0; groupIndex < checkPoint.getNumGroups(); ++groupIndex){
+        const float* groupWeights = &checkPoint.weights[groupIndex * numActions];
+        int numNonZeroWeights = 0;
+        for (int a = 0; a < numActions; a++){
+            numNonZeroWeights += groupWeights[a] != 0;
+        }
+        checkPointFile << numNonZeroWeights;
+        for (int a = 0; a < numActions; a++){
+            if (groupWeights[a] != 0){
+                checkPointFile << " " << a << " " << groupWeights[a];
+            }
+        }
+        checkPointFile << "\t";
+    }
+    checkPointFile << std::endl;
+    for (size_t i = 0; i < checkPoint.translationFeatures.size(); i++){
+        checkPointFile << checkPoint.translationFeatures[i] << " " << checkPoint.translationGroups[i] << "\t";
+    }
+    checkPointFile << std::endl;
+    checkPointFile.close();
+    return !checkPointFile.fail();
+}
+
+bool CheckPointIO::loadText(const std::string& fileName, int numActions, CheckPoint& checkPoint, std::string& error){
+    GzInputStream checkPointToLoad(fileName);
+    if (!checkPointToLoad.is_open()){
+        error = "cannot read " + fileName;
+        return false;
+    }
+    std::mt19937 randomGenerator;
+    checkPointToLoad >> randomGenerator;
+    std::ostringstream randomState;
+    randomState << randomGenerator;
+    checkPoint.randomState = randomState.str();
+    checkPointToLoad >> checkPoint.totalNumberFrames;
+    while (checkPoint.totalNumberFrames < 1000 && checkPointToLoad){
+        checkPointToLoad >> checkPoint.totalNumberFrames;
+    }
+    checkPointToLoad >> checkPoint.episode;
+    checkPointToLoad >> checkPoint.firstReward;
+    checkPointToLoad >> checkPoint.maxFeatVectorNorm;
+    long long numGroups, numberOfFeaturesSeen;
+    checkPointToLoad >> numGroups;
+    checkPointToLoad >> numberOfFeaturesSeen;
+    if (!checkPointToLoad || numGroups < 0){
+        error = fileName + " is not a text check point";
+        return false;
+    }
+    checkPoint.numActions = numActions;
+    checkPoint.groupSizes.assign(numGroups, 0);
+    checkPoint.weights.assign(numGroups * numActions, 0);
+    int action;
+    float weight;
+    int numNonZeroWeights;
+    for (long long groupIndex = 0; groupIndex < numGroups; ++groupIndex){
+        checkPointToLoad >> numNonZeroWeights;
+        for (int i = 0; i < numNonZeroWeights; ++i){
+            checkPointToLoad >> action >> weight;
+            if (action < 0 || action >= numActions){
+                error = fileName + " has a weight of action " + std::to_string(action) + ", there are " + std::to_string(numActions) + " actions";
+                return false;
+            }
+            checkPoint.weights[groupIndex * numActions + action] = weight;
+        }
+    }
+    if (!checkPointToLoad){
+        error = fileName + " is truncated";
+        return false;
+    }
+
+    std::vector<std::pair<long long,int> > translations;
+    translations.reserve(numberOfFeaturesSeen);
+    long long featureIndex;
+    long long featureToGroup;
+    while (checkPointToLoad >> featureIndex && checkPointToLoad >> featureToGroup){
+        if (featureToGroup < 1 || featureToGroup > numGroups){
+            error = fileName + " translates a feature to the unknown group " + std::to_string(featureToGroup);
+            return false;
+        }
+        translations.push_back(std::make_pair(featureIndex, (int) featureToGroup));
+        checkPoint.groupSizes[featureToGroup-1] += 1;
+    }
+    checkPoint.translationFeatures.resize(translations.size());
+    checkPoint.translationGroups.resize(translations.size());
+    for (size_t i = 0; i < translations.size(); i++){
+        checkPoint.translationFeatures[i] = translations[i].first;
+        checkPoint.translationGroups[i] = translations[i].second;
+    }
+    sortTranslations(checkPoint);
+    return true;
+}
+
+void CheckPointIO::sortTranslations(CheckPoint& checkPoint){
+    std::vector<std::pair<long long,int> > translations(checkPoint.translationFeatures.size());
+    for (size_t i = 0; i < translations.size(); i++){
+        translations[i] = std::make_pair(checkPoint.translationFeatures[i], checkPoint.translationGroups[i]);
+    }
+    std::sort(translations.begin(), translations.end());
+    for (size_t i = 0; i < translations.size(); i++){
+        checkPoint.translationFeatures[i] = translations[i].first;
+        checkPoint.translationGroups[i] = translations[i].second;
+    }
+}
+
+bool CheckPointIO::isBinary(const std::string& fileName){
+    char magic[sizeof(MAGIC)];
+    gzFile file = gzopen(fileName.c_str(), "rb");
+    if (file == NULL){
+        return false;
+    }
+    bool binary = gzread(file, magic, sizeof(MAGIC)) == sizeof(MAGIC) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+    gzclose(file);
+    return binary;
+}
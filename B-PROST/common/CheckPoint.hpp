@@ -0,0 +1,114 @@
+/****************************************************************************************
+ ** Contents of a check point of SarsaLearner and the functions that save and load it, in
+ ** the text format (CHECKPOINT_FORMAT = 0) or in the binary one (CHECKPOINT_FORMAT = 1).
+ **
+ ** The binary format is versioned and checksummed, all values are little-endian and of
+ ** fixed width, and the arrays are stored as they are, so loading is a bulk read:
+ **   char[8]  magic "BPROCKPT"
+ **   uint32   version
+ **   uint32   length of the state of the random number generator, followed by it as text
+ **   int64    totalNumberFrames, episode
+ **   float    firstReward
+ **   int64    maxFeatVectorNorm
+ **   int32    numActions
+ **   int64    numGroups, numTranslations
+ **   int64    groupSizes[numGroups]
+ **   float    weights[numGroups][numActions]
+ **   int64    translationFeatures[numTranslations], in increasing order
+ **   int32    translationGroups[numTranslations], numbered from 1
+ **   uint32   CRC-32 of all the bytes before it
+ **
+ ** A delta check point (DELTA_CHECKPOINTS > 0) only has what changed since a full check point:
+ ** the groups whose size or weights are different, all groups created after it and the
+ ** translations to those groups, the only ones that change since features are only moved to new
+ ** groups. It is always binary, as the full one but with the magic "BPRODLTA" and:
+ **   ...      as the full one, up to numActions
+ **   int64    baseTotalNumberFrames, baseNumGroups, of the full check point it applies to
+ **   int64    deltaNumGroups, numRows, numTranslations
+ **   int64    groupIndices[numRows], in increasing order
+ **   int64    groupSizes[numRows]
+ **   float    weights[numRows][numActions]
+ **   int64    translationFeatures[numTranslations], in increasing order
+ **   int32    translationGroups[numTranslations], numbered from 1
+ **   uint32   CRC-32 of all the bytes before it
+ **
+ ** REMARKS: - Both formats can be written compressed with zlib (COMPRESSION_LEVEL > 0), as gzip
+ **            files with the same names, and the loaders read compressed files as well as
+ **            uncompressed ones, decompressing them as they are read.
+ **          - The text format only has the weights with 6 significant digits, the binary one
+ **            has them exactly.
+ **          - The text format does not have the number of actions, it must be known to load it.
+ **          - A delta has all changes since its full check point, not since the previous delta, so
+ **            a check point is restored from the full one and the last delta only.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#include <string>
+#include <vector>
+
+struct CheckPoint{
+    std::string randomState;                //the random number generator, as written by operator<<
+    long long totalNumberFrames;
+    long long episode;
+    float firstReward;
+    long long maxFeatVectorNorm;
+    int numActions;
+    std::vector<long long> groupSizes;      //number of features of each group
+    std::vector<float> weights;             //weights[group * numActions + action]
+    std::vector<long long> translationFeatures;
+    std::vector<int> translationGroups;
+    //Only used by a delta check point:
+    bool isDelta = false;
+    long long baseTotalNumberFrames = 0;    //totalNumberFrames of the full check point it applies to
+    long long baseNumGroups = 0;            //number of groups of that full check point
+    long long deltaNumGroups = 0;           //number of groups once it is applied
+    std::vector<long long> groupIndices;    //group of each entry of groupSizes and of each row of weights
+
+    long long getNumGroups() const{
+        return groupSizes.size();
+    }
+};
+
+class CheckPointIO{
+public:
+    static const unsigned int VERSION = 1;
+    /**
+     * @param int compressionLevel zlib level from 1 to 9 to write it compressed, 0 to write it as it is
+     * @return bool false if the file could not be written
+     */
+    static bool saveBinary(const std::string& fileName, const CheckPoint& checkPoint, int compressionLevel = 0);
+    /**
+     * @param std::string& error receives the reason when the file cannot be loaded: it does not
+     *        exist, it is not a binary check point, its version is unknown or its checksum is wrong
+     * @return bool false if the file could not be loaded
+     */
+    static bool loadBinary(const std::string& fileName, CheckPoint& checkPoint, std::string& error);
+    /**
+     * Writes a delta check point, see the top of this file.
+     */
+    static bool saveDelta(const std::string& fileName, const CheckPoint& delta, int compressionLevel = 0);
+    static bool loadDelta(const std::string& fileName, CheckPoint& delta, std::string& error);
+    /**
+     * Turns a full check point into the one the delta was taken from, i.e. replaces the groups of
+     * the delta, adds the new ones, merges the translations and takes the counters of the delta.
+     * @return bool false, with the reason in error, if the delta was not taken after this check point
+     */
+    static bool applyDelta(CheckPoint& checkPoint, const CheckPoint& delta, std::string& error);
+    /**
+     * Writes the same text SarsaLearner always wrote, with the translations in increasing order.
+     */
+    static bool saveText(const std::string& fileName, const CheckPoint& checkPoint, int compressionLevel = 0);
+    /**
+     * @param int numActions number of actions, which the text format does not have
+     */
+    static bool loadText(const std::string& fileName, int numActions, CheckPoint& checkPoint, std::string& error);
+    /**
+     * Sorts the translations by feature, as both formats have them.
+     */
+    static void sortTranslations(CheckPoint& checkPoint);
+    /**
+     * @return bool true if the file starts as a binary check point
+     */
+    static bool isBinary(const std::string& fileName);
+};
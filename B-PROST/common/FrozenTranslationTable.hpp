@@ -0,0 +1,70 @@
+/****************************************************************************************
+ ** Immutable copy of a FeatureTranslationTable, used by SarsaLearner when it evaluates the
+ ** policy: lookups never modify it, so any number of threads can read it at the same time.
+ ** It is a sorted array of the features and a parallel array of their groups, 12 bytes per
+ ** entry with no empty slots, and a lookup is a binary search of the features.
+ **
+ ** REMARKS: - A feature that is not in the table has group 0, i.e. no group, as in
+ **            FeatureTranslationTable.
+ **          - It does not follow the table it was built from, it must be built again after
+ **            features are added or moved to other groups.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#ifndef FEATURE_TRANSLATION_TABLE_H
+#define FEATURE_TRANSLATION_TABLE_H
+#include "FeatureTranslationTable.hpp"
+#endif
+#include <algorithm>
+#include <vector>
+#include <stddef.h>
+
+class FrozenTranslationTable{
+private:
+    std::vector<long long> features;        //in increasing order
+    std::vector<int> groups;                //groups[i] is the group of features[i]
+
+    FrozenTranslationTable(const FrozenTranslationTable&);
+    FrozenTranslationTable& operator=(const FrozenTranslationTable&);
+
+public:
+    FrozenTranslationTable(){}
+    /**
+     * Replaces the contents by the entries of the table, in time n log n in its size.
+     */
+    void build(const FeatureTranslationTable& table){
+        features.clear();
+        features.reserve(table.size());
+        for (size_t slot = 0; slot < table.getCapacity(); slot++){
+            if (table.isOccupied(slot)){
+                features.push_back(table.getFeature(slot));
+            }
+        }
+        std::sort(features.begin(), features.end());
+        groups.resize(features.size());
+        for (size_t i = 0; i < features.size(); i++){
+            groups[i] = table.get(features[i]);
+        }
+    }
+    /**
+     * Releases the memory of the entries, the table is empty until it is built again.
+     */
+    void clear(){
+        std::vector<long long>().swap(features);
+        std::vector<int>().swap(groups);
+    }
+    /**
+     * @return int the group of the feature, 0 if it has none
+     */
+    int get(long long feature) const{
+        std::vector<long long>::const_iterator it = std::lower_bound(features.begin(), features.end(), feature);
+        if (it == features.end() || *it != feature){
+            return 0;
+        }
+        return groups[it - features.begin()];
+    }
+    size_t size() const{
+        return features.size();
+    }
+};
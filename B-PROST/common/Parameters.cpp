@@ -220,6 +220,72 @@ void Parameters::parseParametersFromConfigFile(std::string cfgFileName){
     }else{
         this->setFinalExplorationFrame(0);
     }
+    
+    if (parameters.count("INCREMENTAL_FEATURES")>0){
+        this->setIncrementalFeatures(atoi(parameters["INCREMENTAL_FEATURES"].c_str()));
+    }else{
+        this->setIncrementalFeatures(0);
+    }
+    
+    if (parameters.count("WEIGHTS_LAYOUT")>0){
+        this->setWeightsLayout(atoi(parameters["WEIGHTS_LAYOUT"].c_str()));
+    }else{
+        this->setWeightsLayout(0);
+    }
+    
+    if (parameters.count("LAZY_TRACES")>0){
+        this->setLazyTraces(atoi(parameters["LAZY_TRACES"].c_str()));
+    }else{
+        this->setLazyTraces(0);
+    }
+    
+    if (parameters.count("FUSED_TRACE_UPDATE")>0){
+        this->setFusedTraceUpdate(atoi(parameters["FUSED_TRACE_UPDATE"].c_str()));
+    }else{
+        this->setFusedTraceUpdate(0);
+    }
+    
+    if (parameters.count("NUM_ACTORS")>0){
+        this->setNumActors(atoi(parameters["NUM_ACTORS"].c_str()));
+    }else{
+        this->setNumActors(1);
+    }
+    
+    if (parameters.count("NUM_EVAL_THREADS")>0){
+        this->setNumEvalThreads(atoi(parameters["NUM_EVAL_THREADS"].c_str()));
+    }else{
+        this->setNumEvalThreads(1);
+    }
+    
+    if (parameters.count("PIPELINED_EXTRACTION")>0){
+        this->setPipelinedExtraction(atoi(parameters["PIPELINED_EXTRACTION"].c_str()));
+    }else{
+        this->setPipelinedExtraction(0);
+    }
+    
+    if (parameters.count("CHECKPOINT_FORMAT")>0){
+        this->setCheckPointFormat(atoi(parameters["CHECKPOINT_FORMAT"].c_str()));
+    }else{
+        this->setCheckPointFormat(0);
+    }
+    
+    if (parameters.count("ASYNC_CHECKPOINT")>0){
+        this->setAsyncCheckPoint(atoi(parameters["ASYNC_CHECKPOINT"].c_str()));
+    }else{
+        this->setAsyncCheckPoint(0);
+    }
+    
+    if (parameters.count("DELTA_CHECKPOINTS")>0){
+        this->setDeltaCheckPoints(atoi(parameters["DELTA_CHECKPOINTS"].c_str()));
+    }else{
+        this->setDeltaCheckPoints(0);
+    }
+    
+    if (parameters.count("COMPRESSION_LEVEL")>0){
+        this->setCompressionLevel(atoi(parameters["COMPRESSION_LEVEL"].c_str()));
+    }else{
+        this->setCompressionLevel(0);
+    }
 }
 
 void Parameters::setSaveTrajectoryPath(std::string name){
@@ -505,3 +571,91 @@ int Parameters::getEpsilonDecay() {
 int Parameters::getFinalExplorationFrame(){
     return this->finalExplorationFrame;
 }
+
+void Parameters::setIncrementalFeatures(int a){
+    this->incrementalFeatures = a;
+}
+
+int Parameters::getIncrementalFeatures(){
+    return this->incrementalFeatures;
+}
+
+void Parameters::setWeightsLayout(int a){
+    this->weightsLayout = a;
+}
+
+int Parameters::getWeightsLayout(){
+    return this->weightsLayout;
+}
+
+void Parameters::setLazyTraces(int a){
+    this->lazyTraces = a;
+}
+
+int Parameters::getLazyTraces(){
+    return this->lazyTraces;
+}
+
+void Parameters::setFusedTraceUpdate(int a){
+    this->fusedTraceUpdate = a;
+}
+
+int Parameters::getFusedTraceUpdate(){
+    return this->fusedTraceUpdate;
+}
+
+void Parameters::setNumActors(int a){
+    this->numActors = a;
+}
+
+int Parameters::getNumActors(){
+    return this->numActors;
+}
+
+void Parameters::setNumEvalThreads(int a){
+    this->numEvalThreads = a;
+}
+
+int Parameters::getNumEvalThreads(){
+    return this->numEvalThreads;
+}
+
+void Parameters::setPipelinedExtraction(int a){
+    this->pipelinedExtraction = a;
+}
+
+int Parameters::getPipelinedExtraction(){
+    return this->pipelinedExtraction;
+}
+
+void Parameters::setCheckPointFormat(int a){
+    this->checkPointFormat = a;
+}
+
+int Parameters::getCheckPointFormat(){
+    return this->checkPointFormat;
+}
+
+void Parameters::setAsyncCheckPoint(int a){
+    this->asyncCheckPoint = a;
+}
+
+int Parameters::getAsyncCheckPoint(){
+    return this->asyncCheckPoint;
+}
+
+void Parameters::setDeltaCheckPoints(int a){
+    this->deltaCheckPoints = a;
+}
+
+int Parameters::getDeltaCheckPoints(){
+    return this->deltaCheckPoints;
+}
+
+void Parameters::setCompressionLevel(int a){
+    this->compressionLevel = a;
+}
+
+int Parameters::getCompressionLevel(){
+    return this->compressionLevel;
+}
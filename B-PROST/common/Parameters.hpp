@@ -56,6 +56,17 @@ class Parameters{
         int noOpMax;
         int epsilonDecay;
         int finalExplorationFrame;
+        int incrementalFeatures;    //whether tiles and pairwise offsets are updated only where the screen changed
+        int weightsLayout;          //0: weights and traces stored [action][group], 1: stored [group][action], padded for SIMD
+        int lazyTraces;             //whether traces decay through a global step counter instead of one by one
+        int fusedTraceUpdate;       //whether traces are decayed in the same pass that updates the weights
+        int numActors;              //number of actor threads sharing the weights, Hogwild when greater than 1
+        int numEvalThreads;         //number of threads of the evaluation, which is parallel when greater than 1
+        int pipelinedExtraction;    //whether actions and feature extraction run in a thread overlapping the weight update
+        int checkPointFormat;       //format of the check points written, 0 for text and 1 for binary
+        int asyncCheckPoint;        //whether check points are written in a thread of their own while learning continues
+        int deltaCheckPoints;       //number of delta check points written between two full ones, 0 to only write full ones
+        int compressionLevel;       //zlib level of the check points and weights files written, 0 to write them uncompressed
     
         std::mt19937 agentRand;
     
@@ -228,6 +239,17 @@ class Parameters{
         void setNoOpMax(int a);
         void setEpsilonDecay(int a);
         void setFinalExplorationFrame(int a);
+        void setIncrementalFeatures(int a);
+        void setWeightsLayout(int a);
+        void setLazyTraces(int a);
+        void setFusedTraceUpdate(int a);
+        void setNumActors(int a);
+        void setNumEvalThreads(int a);
+        void setPipelinedExtraction(int a);
+        void setCheckPointFormat(int a);
+        void setAsyncCheckPoint(int a);
+        void setDeltaCheckPoints(int a);
+        void setCompressionLevel(int a);
 		
 	public:
 		/**
@@ -367,4 +389,15 @@ class Parameters{
         int getNoOpMax();
         int getEpsilonDecay();
         int getFinalExplorationFrame();
+        int getIncrementalFeatures();
+        int getWeightsLayout();
+        int getLazyTraces();
+        int getFusedTraceUpdate();
+        int getNumActors();
+        int getNumEvalThreads();
+        int getPipelinedExtraction();
+        int getCheckPointFormat();
+        int getAsyncCheckPoint();
+        int getDeltaCheckPoints();
+        int getCompressionLevel();
 };
@@ -2,7 +2,14 @@
 ** This class is used to store the background, which may be subtracted from screen to
 ** generate features. This approach was suggested in the JAIR paper and drastically
 ** reduces the number of features in the problem.
-** 
+**
+** REMARKS: - The background is read from a packed binary file (game.bgb) next to the
+**            text file (game.bg), written by tools/convertBackgrounds.py. If it does not
+**            exist, or is older than the text file, the text file is parsed instead.
+**            The binary file is mapped in memory, it is never parsed.
+**          - Binary format: the 4 bytes "BGB2", width and height as 32-bit little-endian
+**            integers, followed by the width x height pixels, one byte each, row by row.
+**
 ** Author: Marlos C. Machado
 ***************************************************************************************/
 
@@ -17,12 +24,26 @@ class Background{
 		int height;
 		int down_width;
 		int down_height;
-		std::vector<std::vector<int> > background;
+		const unsigned char* pixels;             //width x height pixels, row by row
+		void* mappedFile;                        //the binary file, when it was mapped in memory
+		size_t mappedSize;
+		std::vector<unsigned char> ownedPixels;  //the pixels, when they were parsed from the text file
 
 		/**
 		* Constructor, private so no one calls it without the proper information.
 		*/
 		Background();
+		/**
+		* Maps the binary background file in memory.
+		* @param std::string path to the binary file
+		* @return bool whether the file exists, is valid and could be mapped
+		*/
+		bool loadBinary(std::string path);
+		/**
+		* Parses the comma-separated text background file, filling ownedPixels.
+		* @param std::string path to the text file
+		*/
+		void loadText(std::string path);
 	public:
 		/**
 		* Constructor to be used.
@@ -30,14 +51,12 @@ class Background{
 		*/
 		Background(Parameters *param);
 		/**
-		* Destructor used to delete the background, which is allocated dynamically
+		* Destructor used to unmap the background file
 		*/
 		~Background();
 		/**
 		* Method used to retrieve a pixel from the background.
-		* 
-		* TODO: Make it return an unsigned char, it is more efficient.
-		* 
+		*
 		* @param int x coordinate
 		* @param int y coordinate
 		*
@@ -45,6 +64,11 @@ class Background{
 		*/
 		int getPixel(int x, int y);
 		/**
+		* @param int y the row of the screen
+		* @return const unsigned char* pointer to the width raw pixels of the row
+		*/
+		const unsigned char* getRow(int y);
+		/**
 		* @return int background screen width
 		*/
 		int getWidth();
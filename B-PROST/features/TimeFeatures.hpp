@@ -16,6 +16,10 @@
 #define BACKGROUND_H
 #include "Background.hpp"
 #endif
+#ifndef STAMP_TABLE_H
+#define STAMP_TABLE_H
+#include "../common/StampTable.hpp"
+#endif
 
 #include<tuple>
 #include<unordered_map>
@@ -30,17 +34,29 @@ class TimeFeatures : public Features::Features{
         long long numBasicFeatures, numRelativeFeatures, numTimeDimensionalOffsets;
         int numColumns, numRows, numColors;
     
-        vector<vector<bool> > pairwiseExistence;
-        vector<tuple<int,int> > pairwiseChanged;
+        StampTable pairwiseStamps;                  //offsets added for the current pair of colors
     
         vector<vector<tuple<int,int> > > previousColors;
+        vector<int> activeColors, previousActiveColors;     //colors with at least one tile in the current and previous frames
+    
+        vector<unsigned long long> tileColors;      //128-bit color-presence mask per tile, two words each
+        vector<int> columnToTile;                   //tile column of each screen column
+        vector<unsigned int> colorOccupancy;        //tiles of each color, one bit per column and one word per row
+        vector<unsigned char> previousScreen;       //last screen seen in incremental mode, used to find the dirty tiles
+        vector<unsigned short> pairOffsetCounts;    //pairs of tiles at each offset of each color pair, in incremental mode
+        vector<unsigned long long> pairOffsetRows;  //offsets with a nonzero count, one word per row offset of each color pair
+        vector<int> colorTileCount;                 //number of tiles of each color, in incremental mode
+        unsigned long long presentColors[2];        //colors with a nonzero tile count
     
+        void quantizeRow(const unsigned char* row, const unsigned char* backgroundRow, unsigned char* quantized, int width);
+        void updateDirtyTiles(const ALEScreen &screen, int blockWidth, int blockHeight);
+        void updatePairOffsetCounts(int row, int column, int color, int delta);
         int getBasicFeaturesIndices(const ALEScreen &screen, int blockWidth, int blockHeight,
             vector<vector<tuple<int,int> > > &whichColors, vector<long long>& features);
 		void addRelativeFeaturesIndices(const ALEScreen &screen, long long featureIndex,
             vector<vector<tuple<int,int> > > &whichColors, vector<long long>& features);
+        void addRelativeFeaturesIndicesFromCounts(vector<long long>& features);
         void addTimeOffsetsIndices(vector<vector<tuple<int,int> > >& whichColors, vector<long long>& features);
-        void resetPairwiseExistence();
     
 	public:
 		/**
@@ -25,6 +25,15 @@
 #define BASIC_H
 #include "features/TimeFeatures.hpp"
 #endif
+#ifndef TIMER_H
+#define TIMER_H
+#include "common/Timer.hpp"
+#endif
+#ifndef ALE_SETUP_H
+#define ALE_SETUP_H
+#include "common/ALESetup.hpp"
+#endif
+#include <thread>
 
 //#include <random>
 
@@ -41,6 +50,98 @@ void printBasicInfo(Parameters param){
 		param.getEpisodeLength());
 }
 
+/**
+ * An actor of the Hogwild learning or a worker of the parallel evaluation, with its own ALE, features
+ * and copy of the parameters (hence of the random number generator). They share the weights.
+ */
+struct Actor{
+	Parameters* param;
+	TimeFeatures* features;
+	ALEInterface* ale;
+	SarsaLearner* learner;
+};
+
+/**
+ * Creates actors 1 to numActors-1, actor 0 is the one created in main. Actor k is seeded with
+ * seed + seedStep * k.
+ */
+vector<Actor> createActors(Parameters& param, SharedWeights& sharedWeights, int numActors, int seedStep){
+	vector<Actor> actors;
+	for(int actor = 1; actor < numActors; actor++){
+		int actorSeed = param.getSeed() + seedStep * actor;
+		Actor newActor;
+		newActor.param = new Parameters(param);
+		newActor.features = new TimeFeatures(newActor.param);
+		newActor.ale = new ALEInterface(false);
+		setUpALE(*newActor.ale, param, actorSeed);
+		newActor.learner = new SarsaLearner(*newActor.ale, newActor.features, newActor.param, 2*actorSeed-1, &sharedWeights, actor);
+		actors.push_back(newActor);
+	}
+	return actors;
+}
+
+void deleteActors(vector<Actor>& actors){
+	for(unsigned int i = 0; i < actors.size(); i++){
+		delete actors[i].learner;
+		delete actors[i].ale;
+		delete actors[i].features;
+		delete actors[i].param;
+	}
+	actors.clear();
+}
+
+/**
+ * Hogwild learning (NUM_ACTORS > 1): actors 1 to NUM_ACTORS-1 run in their own threads, actor 0 runs
+ * in the main thread. They all stop when the frames learned by all of them reach TOTAL_FRAMES_LEARN.
+ */
+void learnWithActors(ALEInterface& ale, TimeFeatures& features, SarsaLearner& sarsaLearner, Parameters& param, SharedWeights& sharedWeights){
+	int numActors = param.getNumActors();
+	vector<Actor> actors = createActors(param, sharedWeights, numActors, 1000);
+
+	struct timeval tvBegin, tvEnd, tvDiff;
+	gettimeofday(&tvBegin, NULL);
+	vector<std::thread> actorThreads;
+	for(unsigned int i = 0; i < actors.size(); i++){
+		actorThreads.push_back(std::thread(&SarsaLearner::learnPolicy, actors[i].learner, std::ref(*actors[i].ale), actors[i].features));
+	}
+	sarsaLearner.learnPolicy(ale, &features);
+	for(unsigned int i = 0; i < actorThreads.size(); i++){
+		actorThreads[i].join();
+	}
+	gettimeofday(&tvEnd, NULL);
+	timeval_subtract(&tvDiff, &tvEnd, &tvBegin);
+	double elapsedTime = double(tvDiff.tv_sec) + double(tvDiff.tv_usec)/1000000.0;
+	printf("\n%d actors learned for %d frames in %.1f seconds, %.0f fps in aggregate\n",
+		numActors, (int) sharedWeights.totalNumberFrames, elapsedTime, sharedWeights.totalNumberFrames / elapsedTime);
+
+	deleteActors(actors);
+}
+
+/**
+ * Parallel evaluation (NUM_EVAL_THREADS > 1): the episodes are split among the workers, worker 0 is
+ * the learner created in main and runs in the main thread. The weights are not changed, and all workers
+ * read the groups from the same frozen table. All workers have the seed of the main ALE, the random
+ * number generators are seeded at every episode.
+ */
+void evaluateWithWorkers(ALEInterface& ale, TimeFeatures& features, SarsaLearner& sarsaLearner, Parameters& param, SharedWeights& sharedWeights){
+	sarsaLearner.freezeGroups();
+	vector<Actor> workers = createActors(param, sharedWeights, param.getNumEvalThreads(), 0);
+	std::atomic<int> nextEpisode(1);
+	vector<double> episodeScores(param.getNumEpisodesEval(), 0);
+
+	vector<std::thread> workerThreads;
+	for(unsigned int i = 0; i < workers.size(); i++){
+		workerThreads.push_back(std::thread(&SarsaLearner::evaluateEpisodes, workers[i].learner, std::ref(*workers[i].ale), workers[i].features, std::ref(nextEpisode), std::ref(episodeScores)));
+	}
+	sarsaLearner.evaluateEpisodes(ale, &features, nextEpisode, episodeScores);
+	for(unsigned int i = 0; i < workerThreads.size(); i++){
+		workerThreads[i].join();
+	}
+	sarsaLearner.releaseFrozenGroups();
+	sarsaLearner.saveEvaluationResults(episodeScores);
+
+	deleteActors(workers);
+}
 
 int main(int argc, char** argv){
 	//Reading parameters from file defined as input in the run command:
@@ -54,23 +155,26 @@ int main(int argc, char** argv){
 	
 	ALEInterface ale(param.getDisplay());
 
-	ale.setFloat("repeat_action_probability", 0.00);
-	ale.setInt("random_seed", 2*param.getSeed());
-	ale.setInt("frame_skip", param.getNumStepsPerAction());
-	ale.setInt("max_num_frames_per_episode", param.getEpisodeLength());
-    ale.setBool("color_averaging", true);
-
-	ale.loadROM(param.getRomPath().c_str());
+	setUpALE(ale, param, param.getSeed());
 
     //mt19937 agentRand(param.getSeed());
 	//Instantiating the learning algorithm:
-	SarsaLearner sarsaLearner(ale, &features, &param, 2*param.getSeed()-1);
+	SharedWeights sharedWeights(param.getNumActors());
+	SarsaLearner sarsaLearner(ale, &features, &param, 2*param.getSeed()-1, &sharedWeights);
     //Learn a policy:
-    sarsaLearner.learnPolicy(ale, &features);
+    if(param.getNumActors() > 1){
+        learnWithActors(ale, features, sarsaLearner, param, sharedWeights);
+    }else{
+        sarsaLearner.learnPolicy(ale, &features);
+    }
     
 
     printf("\n\n== Evaluation without Learning == \n\n");
-    sarsaLearner.evaluatePolicy(ale, &features);
+    if(param.getNumEvalThreads() > 1){
+        evaluateWithWorkers(ale, features, sarsaLearner, param, sharedWeights);
+    }else{
+        sarsaLearner.evaluatePolicy(ale, &features);
+    }
 	
     return 0;
 }
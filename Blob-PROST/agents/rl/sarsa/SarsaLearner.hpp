@@ -13,8 +13,35 @@
 #define RLLEARNER_H
 #include "../RLLearner.hpp"
 #endif
+#ifndef FEATURE_TRANSLATION_TABLE_H
+#define FEATURE_TRANSLATION_TABLE_H
+#include "../../../common/FeatureTranslationTable.hpp"
+#endif
+#ifndef FROZEN_TRANSLATION_TABLE_H
+#define FROZEN_TRANSLATION_TABLE_H
+#include "../../../common/FrozenTranslationTable.hpp"
+#endif
+#ifndef WEIGHT_TABLE_H
+#define WEIGHT_TABLE_H
+#include "../../../common/WeightTable.hpp"
+#endif
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+#include "../../../common/SPSCRing.hpp"
+#endif
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include "../../../common/CheckPoint.hpp"
+#endif
+#ifndef VECTOR_ENV_H
+#define VECTOR_ENV_H
+#include "../../../common/VectorEnv.hpp"
+#endif
 #include <vector>
-#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <pthread.h>
+#include <sys/time.h>
 //#include <sparsehash/dense_hash_map>
 using namespace std;
 //using google::dense_hash_map;
@@ -24,13 +51,84 @@ struct Group{
     vector<long long> features;
 };
 
+/**
+ * What the actors of a Hogwild run (NUM_ACTORS > 1) share: the groups and their weights. Each actor
+ * has its own ALE, features, random number generator and traces. The weights are updated without
+ * any synchronization, as in Hogwild. The lock is only held exclusively to change the structure,
+ * i.e. to add features, create or split groups and grow the weight table; the actors hold it shared
+ * while they read or update the weights and release it while they act and extract features.
+ * With a single actor the lock is never used.
+ */
+struct SharedWeights{
+    WeightTable w;
+    FeatureTranslationTable featureTranslate;
+    FrozenTranslationTable frozenTranslate;  //copy of featureTranslate read by the evaluation, see freezeGroups
+    vector<Group> groups;
+    long long numGroups;
+    int numActors;
+    std::atomic<int> totalNumberFrames;      //frames learned by all actors
+    pthread_rwlock_t lock;
+
+    SharedWeights(int numActors);
+    ~SharedWeights();
+};
+
+/**
+ * What the extraction thread returns for each action, with PIPELINED_EXTRACTION.
+ */
+struct Transition{
+    vector<float> reward;           //as returned by RLLearner::act
+    int gameOver;
+    vector<long long> features;     //active features of the new screen, if the game is not over
+};
+
+/**
+ * What each emulator of a VectorEnv has of its own while learning: its transition, traces and episode.
+ * It is swapped with the corresponding members of the learner while the emulator is processed, so the
+ * traces and the updates are done by the same code used with a single emulator.
+ */
+struct EnvState{
+    vector<long long> F, Fnext;
+    vector<float> Q, Qnext;
+    WeightTable e;
+    ActionGroupTable<int> eStep;
+    vector<vector<long long> > nonZeroElig;
+    int traceStep;
+    int currentAction, nextAction;
+    long long trueFeatureSize;
+    int active;                     //0 once the emulator finished its last episode
+    int episode;
+    unsigned int noOpNum;
+    double episodeReward;
+    struct timeval episodeBegin;
+};
+
 class SarsaLearner : public RLLearner{
 private:
+    SharedWeights* ownWeights;      //only allocated without Hogwild
+    SharedWeights* shared;
+    int actor;                      //index of this actor, 0 without Hogwild
+    int hogwild;
+    WeightTable& w;                 //Theta, weights vector, w(action,group)
+    FeatureTranslationTable& featureTranslate;     //group of each feature seen, numbered from 1
+    vector<Group>& groups;
+    long long& numGroups;
     float alpha, delta, lambda, traceThreshold;
     float learningRate;
     int currentAction, nextAction;
     long long numFeatures;
     int toSaveWeightsAfterLearning, saveWeightsEveryXFrames, toSaveCheckPoint;
+    int checkPointFormat;           //0 for text check points, 1 for binary ones, see CheckPoint.hpp
+    int asyncCheckPoint;            //If set, check points are written by checkPointThread while learning continues
+    int compressionLevel;           //zlib level of the check points and weights files, 0 to not compress them
+    std::thread checkPointThread;
+    int deltaCheckPoints;           //Number of delta check points written between two full ones, see CheckPoint.hpp
+    int deltasSinceFull;            //-1 until the first full check point of this run is taken
+    vector<long long> fullGroupSizes;   //groups and weights of the last full check point, what the
+    vector<float> fullWeights;          //deltas are taken against
+    long long fullTotalNumberFrames;
+    int fullThreshold;
+    std::string lastFullCheckPoint, lastDeltaCheckPoint;
     
     std::string nameWeightsFile, pathWeightsFileToLoad;
     std::string checkPointName;
@@ -42,19 +140,24 @@ private:
     int randomNoOp;
     int noOpMax;
     int numStepsPerAction;
-    
-    long long numGroups;
+    int evaluationSeed;
     
     vector<long long> F;					//Set of features active
     vector<long long> Fnext;              //Set of features active in next state
     vector<float> Q;               //Q(a) entries
     vector<float> Qnext;           //Q(a) entries for next action
-    vector<vector<float> > e;       //Eligibility trace
-    vector<vector<float> > w;     //Theta, weights vector
+    WeightTable e;                  //Eligibility trace, e(action,group)
     vector<vector<long long> >nonZeroElig;//To optimize the implementation
+    int lazyTraces;                 //If set, traces are not decayed one by one at every step, see getTrace
+    ActionGroupTable<int> eStep;    //Step at which each trace was last set, with lazy traces
+    vector<float> traceDecay;       //Value of a trace set to 1 after k steps, with lazy traces
+    int traceStep;                  //Steps since the traces were cleared, with lazy traces
+    int fusedTraceUpdate;           //If set, traces are decayed in the same sweep that updates the weights
     //vector<vector<long long> > featureSeen;
-    unordered_map<long long,long long> featureTranslate;
-    vector<Group> groups;
+    int pipelinedExtraction;        //If set, actions and features extraction run in a thread of their own
+    SPSCRing<int> actionRing;       //learner -> extraction thread, -1 stops the thread
+    SPSCRing<Transition> transitionRing;  //extraction thread -> learner
+    vector<int> activeGroupCount;   //scratch of findExistingGroups and updateFrozenQValues, one entry per group
     
     /**
      * Constructor declared as private to force the user to instantiate SarsaLearner
@@ -73,6 +176,14 @@ private:
      * that are active in F.
      */
     void updateQValues(vector<long long> &Features, vector<float> &QValues);
+    /**
+     * Q-values of the active features without changing the groups, for the evaluation. The groups are
+     * read from the frozen table, see freezeGroups. A group contributes its weight times the number of
+     * its features that are active, which is what the groups created by groupFeatures would contribute:
+     * features never seen have no group, and would form one with zero weights, and the part of a group
+     * split by groupFeatures keeps the weights of the group.
+     */
+    void updateFrozenQValues(vector<long long> &Features, vector<float> &QValues);
     /**
      * When using Replacing traces, all values not related to the current action are set to 0, while the
      * values for the current action that their features are active are set to 1. The traces decay following
@@ -85,6 +196,31 @@ private:
      * the rule: e[action][i] = gamma * lambda * e[action][i]. It is possible to also define thresholding.
      */
     void updateAcumTrace(int action, vector<long long> &Features);
+    /**
+     * With lazy traces e(action,group) is the value the trace had when it was last set, at step
+     * eStep(action,group), and its current value is that times traceDecay[traceStep - eStep]. So
+     * decaying all traces is just incrementing traceStep. traceDecay is built with the same
+     * multiplications updateReplTrace does at every step, so replacing traces have exactly
+     * the same values. Traces below the threshold are only removed during the weight update.
+     * With fused trace updates it returns the value the trace will have after this step's
+     * decay, i.e. after decayTracesAndUpdateWeights. Otherwise it just returns e(action,group).
+     */
+    float getTrace(int action, long long group);
+    /**
+     * With fused trace updates updateReplTrace only marks the traces of the active features with
+     * -1, and this method does, in a single pass over nonZeroElig, what updateReplTrace and the
+     * weight update do in two: it decays each trace (or sets it to 1 if marked), zeroes the ones
+     * below the threshold, updates the weights and compacts nonZeroElig. Runs of 4 consecutive
+     * groups are processed with SIMD in the action-major layout. The weights are the same as
+     * updating them separately.
+     *
+     * @param float weightStep learningRate * delta
+     */
+    void decayTracesAndUpdateWeights(float weightStep);
+    /**
+     * Sets the current value of a lazy trace.
+     */
+    void setTrace(int action, long long group, float value);
     /**
      * Prints the weights in a file. Each line will contain a weight.
      */
@@ -94,10 +230,78 @@ private:
      */
     void loadWeights();
     void saveCheckPoint(int episode, int totalNumberFrames,  vector<float>& episodeResults, int& frequency, vector<int>& episodeFrames, vector<double>& episodeFps);
-    void loadCheckPoint(ifstream& checkPointToLoad);
+    /**
+     * Copies what a check point has, i.e. the random number generator, the counters, the groups
+     * with their weights and the translation of the features to the groups, not sorted yet.
+     * @param bool delta if set, only the groups and translations that changed since the last full
+     *        check point are copied, found by comparing the groups with fullGroupSizes and fullWeights
+     */
+    void getCheckPoint(CheckPoint& checkPoint, int episode, int totalNumberFrames, bool delta = false);
+    /**
+     * Writes a snapshot taken by getCheckPoint, deletes it and renames the file from -writing to
+     * -finished, removing the previous versions. With ASYNC_CHECKPOINT it runs in checkPointThread:
+     * the snapshot is a copy, so learning goes on while it is written.
+     */
+    void writeCheckPoint(CheckPoint* checkPoint, string currentCheckPointName, vector<string> previousVersions);
+    /**
+     * Waits until the check point being written by checkPointThread, if any, is finished.
+     */
+    void waitForCheckPoint();
+    void loadCheckPoint(const CheckPoint& checkPoint);
     void groupFeatures(vector<long long>& activeFeatures);
+    /**
+     * Read-only version of groupFeatures for Hogwild actors: if all active features already have a
+     * group and no group has to be split, it replaces the features by their groups, in the same order
+     * groupFeatures would, and returns true. Otherwise it returns false and activeFeatures is unchanged.
+     * Called with the lock held shared.
+     */
+    bool findExistingGroups(vector<long long>& activeFeatures);
+    /**
+     * Replaces the active features by their groups. Without Hogwild it is groupFeatures. With it, if
+     * findExistingGroups fails, the lock is taken exclusively to run groupFeatures, and the traces of
+     * this actor are grown to the groups the other actors created. Called with the lock held shared.
+     */
+    void groupActiveFeatures(vector<long long>& activeFeatures);
+    /**
+     * Adds to the traces of this actor the groups created by the other actors since they were last
+     * grown, with zero traces.
+     */
+    void growTraces();
+    /**
+     * Loop of the extraction thread of PIPELINED_EXTRACTION. For each action from actionRing it acts and
+     * extracts the features of the new screen, which it sends in transitionRing. Nothing of this depends
+     * on the weights, so the learner updates the weights and traces of the previous transition meanwhile,
+     * and the result is exactly the same as doing everything in sequence. The learner only uses the ALE
+     * and the features itself between episodes, when this thread is waiting for an action.
+     */
+    void extractFeatures(ALEInterface& ale, Features *features);
+    /**
+     * Sets all traces to zero, at the beginning of each episode.
+     */
+    void clearTraces();
+    /**
+     * w <- w + learningRate * delta * e, for the non-zero traces, decaying them first with fused
+     * trace updates and zeroing the lazy traces below the threshold.
+     */
+    void updateWeights();
+    /**
+     * Exchanges the state of an emulator of learnPolicyBatched with the members of the learner.
+     */
+    void swapEnvState(EnvState& state);
+    /**
+     * Starts an episode of an emulator of learnPolicyBatched, with its state swapped in: no-ops,
+     * features of the first screen and first action.
+     */
+    void startEnvEpisode(VectorEnv& env, Features *features, int envIndex, EnvState& state, int episode);
+    void lockWeights(int exclusive);
+    void unlockWeights();
 public:
-    SarsaLearner(ALEInterface& ale, Features *features, Parameters *param,int seed);
+    /**
+     * @param SharedWeights* sharedWeights the weights shared by all actors of a Hogwild run, it is
+     *        NULL when there is a single actor. Actor 0 must be the first one constructed.
+     * @param int actorIndex index of the actor, only actor 0 saves check points and evaluates the policy
+     */
+    SarsaLearner(ALEInterface& ale, Features *features, Parameters *param, int seed, SharedWeights* sharedWeights = NULL, int actorIndex = 0);
     /**
      * Implementation of an agent controller. This implementation is Sarsa(lambda).
      *
@@ -106,15 +310,52 @@ public:
      * @param Features *features object that defines what feature function that will be used.
      */
     void learnPolicy(ALEInterface& ale, Features *features);
+    /**
+     * Sarsa(lambda) with several emulators (NUM_ENVS > 1) stepped together by one thread. At every tick
+     * each emulator takes its action, the screens of all of them are given to the batch API of the
+     * features, and the K transitions are learned one after the other, each with its own traces, so
+     * with a single emulator it is exactly learnPolicy. An emulator that finishes an episode starts the
+     * next one in the same tick, until TOTAL_FRAMES_LEARN frames were learned. Hogwild and pipelined
+     * extraction are not used here.
+     *
+     * @param VectorEnv& env the emulators, each with its index in the batch API of the features
+     */
+    void learnPolicyBatched(VectorEnv& env, Features *features);
+    /**
+     * Copies the translation of the features to the frozen table the evaluation reads, shared by all
+     * actors. It must be called after learning and before evaluateEpisodes, evaluatePolicy calls it.
+     */
+    void freezeGroups();
+    /**
+     * Frees the frozen table once no evaluation reads it any more, freezeGroups builds it again.
+     */
+    void releaseFrozenGroups();
     /**
      * After the policy was learned it is necessary to evaluate its quality. Therefore, a given number
-     * of episodes is run without learning (the vector of weights and the trace are not updated).
+     * of episodes is run without learning (the vector of weights and the trace are not updated). The
+     * groups are not changed either, features never seen while learning have no group. The episodes
+     * are played by evaluateEpisodes, as a parallel evaluation with a single worker would play them.
      *
      * @param ALEInterface& ale Arcade Learning Environment interface: object used to define agents'
      *        actions, obtain simulator's screen, RAM, etc.
      * @param Features *features object that defines what feature function that will be used.
      */
     void evaluatePolicy(ALEInterface& ale, Features *features);
+    /**
+     * Parallel version of evaluatePolicy (NUM_EVAL_THREADS > 1), run by each worker in its own thread,
+     * with its own ALE, features and random number generator. The weights and groups are read-only. The
+     * worker evaluates the episodes it takes from nextEpisode until there are no more. The random number
+     * generator is seeded at the beginning of each episode with the seed and the episode number, so the
+     * score of an episode does not depend on the worker that played it or on the number of workers.
+     *
+     * @param std::atomic<int>& nextEpisode next episode to be evaluated, shared by all workers
+     * @param vector<double>& episodeScores receives the score of each episode evaluated
+     */
+    void evaluateEpisodes(ALEInterface& ale, Features *features, std::atomic<int>& nextEpisode, vector<double>& episodeScores);
+    /**
+     * Writes the scores of the parallel evaluation to the same -Result-finished.txt file evaluatePolicy writes.
+     */
+    void saveEvaluationResults(vector<double>& episodeScores);
     /**
      * Destructor, not necessary in this class.
      */
@@ -0,0 +1,89 @@
+/****************************************************************************************
+** Benchmark of the compression of the check points (COMPRESSION_LEVEL in the config file).
+** It writes the given check point in both formats with each zlib level and reports the size
+** of the file, the compression ratio and the throughput of writing and loading it, the
+** throughput being of the uncompressed bytes. It does not need ALE.
+**
+** Usage: ./benchCompression <check point> [numActions] [output file]
+**        The output file, by default the check point with the suffix ".bench", is removed
+**        at the end; it should be on the file system the check points are written to.
+**
+** Author: Marlos C. Machado
+***************************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include "common/CheckPoint.hpp"
+#endif
+#ifndef TIMER_H
+#define TIMER_H
+#include "common/Timer.hpp"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <string>
+using namespace std;
+
+static double elapsedSeconds(struct timeval& begin){
+    struct timeval end, diff;
+    gettimeofday(&end, NULL);
+    timeval_subtract(&diff, &end, &begin);
+    return double(diff.tv_sec) + double(diff.tv_usec)/1000000.0;
+}
+
+static double fileMegabytes(const string& fileName){
+    struct stat fileStat;
+    return stat(fileName.c_str(), &fileStat) == 0 ? fileStat.st_size / 1048576.0 : 0;
+}
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        printf("Usage: %s <check point> [numActions] [output file]\n", argv[0]);
+        return 1;
+    }
+    string inputName = argv[1];
+    int numActions = argc > 2 ? atoi(argv[2]) : 18;
+    string outputName = argc > 3 ? argv[3] : inputName + ".bench";
+
+    CheckPoint checkPoint;
+    string error;
+    bool loaded = CheckPointIO::isBinary(inputName) ? CheckPointIO::loadBinary(inputName, checkPoint, error) : CheckPointIO::loadText(inputName, numActions, checkPoint, error);
+    if(!loaded){
+        printf("Unable to load the check point: %s\n", error.c_str());
+        return 1;
+    }
+    printf("%lld groups, %zu features, %d actions\n", checkPoint.getNumGroups(), checkPoint.translationFeatures.size(), checkPoint.numActions);
+    printf("format level     size (MB)   ratio   write (MB/s)   load (MB/s)\n");
+
+    for(int binary = 1; binary >= 0; binary--){
+        double uncompressedMegabytes = 0;
+        for(int level = 0; level <= 9; level++){
+            struct timeval begin;
+            gettimeofday(&begin, NULL);
+            bool saved = binary ? CheckPointIO::saveBinary(outputName, checkPoint, level) : CheckPointIO::saveText(outputName, checkPoint, level);
+            double writeSeconds = elapsedSeconds(begin);
+            if(!saved){
+                printf("Unable to write %s\n", outputName.c_str());
+                return 1;
+            }
+            double megabytes = fileMegabytes(outputName);
+            if(level == 0){
+                uncompressedMegabytes = megabytes;
+            }
+
+            CheckPoint reloaded;
+            gettimeofday(&begin, NULL);
+            loaded = binary ? CheckPointIO::loadBinary(outputName, reloaded, error) : CheckPointIO::loadText(outputName, checkPoint.numActions, reloaded, error);
+            double loadSeconds = elapsedSeconds(begin);
+            if(!loaded){
+                printf("Unable to load %s: %s\n", outputName.c_str(), error.c_str());
+                return 1;
+            }
+            printf("%-6s %5d %13.2f %7.2f %14.1f %13.1f\n", binary ? "binary" : "text", level, megabytes,
+                   uncompressedMegabytes / megabytes, uncompressedMegabytes / writeSeconds, uncompressedMegabytes / loadSeconds);
+        }
+    }
+    remove(outputName.c_str());
+    return 0;
+}
@@ -0,0 +1,149 @@
+/****************************************************************************************
+** Benchmark of BlobTimeFeatures on recorded screens. The screens are read from a file of raw
+** 210x160 frames, or, if it does not exist, recorded in it by playing the game of the ROM with
+** random actions. The features of all screens are extracted once to warm up, then again to
+** measure the time per frame and the number of heap allocations per frame, which are counted
+** by replacing operator new. It also prints a checksum of the features, in their order, to
+** compare the output of different versions of the extraction.
+**
+** Usage: ./benchFeatures -c <config> -r <rom> -s <seed> [screens file] [numFrames]
+**        The configuration file is the one of the learner, numFrames (default 2000) is only
+**        used to record the screens.
+**
+** Author: Marlos C. Machado
+***************************************************************************************/
+
+#ifndef ALE_INTERFACE_H
+#define ALE_INTERFACE_H
+#include <ale_interface.hpp>
+#endif
+#ifndef PARAMETERS_H
+#define PARAMETERS_H
+#include "common/Parameters.hpp"
+#endif
+#ifndef BASIC_H
+#define BASIC_H
+#include "features/BlobTimeFeatures.hpp"
+#endif
+#ifndef TIMER_H
+#define TIMER_H
+#include "common/Timer.hpp"
+#endif
+#ifndef ALE_SETUP_H
+#define ALE_SETUP_H
+#include "common/ALESetup.hpp"
+#endif
+#include <atomic>
+#include <fstream>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+using namespace std;
+
+static std::atomic<long long> numAllocations(0);
+
+void* operator new(size_t size){
+    numAllocations++;
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (memory == NULL){
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t size) noexcept{
+    free(memory);
+}
+
+static const int SCREEN_SIZE = 210 * 160;
+
+static double elapsedSeconds(struct timeval& begin){
+    struct timeval end, diff;
+    gettimeofday(&end, NULL);
+    timeval_subtract(&diff, &end, &begin);
+    return double(diff.tv_sec) + double(diff.tv_usec)/1000000.0;
+}
+
+static bool readScreens(const string& fileName, vector<pixel_t>& screens){
+    ifstream screensFile(fileName.c_str(), ios::binary | ios::ate);
+    if (!screensFile.is_open()){
+        return false;
+    }
+    long long bytes = screensFile.tellg();
+    screens.resize(bytes / SCREEN_SIZE * SCREEN_SIZE);
+    screensFile.seekg(0);
+    screensFile.read((char*) &screens[0], screens.size());
+    return screensFile.good() && screens.size() > 0;
+}
+
+static void recordScreens(Parameters& param, int numFrames, vector<pixel_t>& screens){
+    ALEInterface ale(false);
+    setUpALE(ale, param, param.getSeed());
+    ActionVect actions = ale.getMinimalActionSet();
+    std::mt19937 generator(param.getSeed());
+    screens.resize((size_t) numFrames * SCREEN_SIZE);
+    for (int frame = 0; frame < numFrames; frame++){
+        memcpy(&screens[(size_t) frame * SCREEN_SIZE], ale.getScreen().getArray(), SCREEN_SIZE * sizeof(pixel_t));
+        ale.act(actions[generator() % actions.size()]);
+        if (ale.game_over()){
+            ale.reset_game();
+        }
+    }
+}
+
+/**
+ * @return double seconds taken to extract the features of all screens
+ */
+static double extractAll(BlobTimeFeatures& features, const vector<pixel_t>& screens, long long& numFeatures, unsigned long long& checksum){
+    vector<long long> F;
+    F.reserve(1 << 16);
+    numFeatures = 0;
+    checksum = 14695981039346656037ULL;
+    features.clearCash(0);
+    int numFrames = screens.size() / SCREEN_SIZE;
+    struct timeval begin;
+    gettimeofday(&begin, NULL);
+    for (int frame = 0; frame < numFrames; frame++){
+        F.clear();
+        features.getActiveFeaturesIndices(&screens[(size_t) frame * SCREEN_SIZE], 0, F);
+        numFeatures += F.size();
+        for (unsigned int i = 0; i < F.size(); i++){
+            checksum = (checksum ^ (unsigned long long) F[i]) * 1099511628211ULL;
+        }
+    }
+    return elapsedSeconds(begin);
+}
+
+int main(int argc, char** argv){
+    Parameters param(argc, argv);
+    string screensName = optind < argc ? argv[optind] : "screens.bin";
+    int numFrames = optind + 1 < argc ? atoi(argv[optind + 1]) : 2000;
+
+    vector<pixel_t> screens;
+    if (!readScreens(screensName, screens)){
+        recordScreens(param, numFrames, screens);
+        ofstream screensFile(screensName.c_str(), ios::binary);
+        screensFile.write((const char*) &screens[0], screens.size());
+        printf("Recorded %d screens in %s\n", numFrames, screensName.c_str());
+    }
+    numFrames = screens.size() / SCREEN_SIZE;
+
+    BlobTimeFeatures features(&param);
+    long long numFeatures;
+    unsigned long long checksum;
+    long long allocationsBefore = numAllocations;
+    double warmUpSeconds = extractAll(features, screens, numFeatures, checksum);
+    long long warmUpAllocations = numAllocations - allocationsBefore;
+    allocationsBefore = numAllocations;
+    double seconds = extractAll(features, screens, numFeatures, checksum);
+    long long allocations = numAllocations - allocationsBefore;
+
+    printf("%d screens, %.1f features per frame, checksum %016llx\n", numFrames, double(numFeatures) / numFrames, checksum);
+    printf("warm-up:  %9.1f us per frame %9.2f allocations per frame\n", 1000000 * warmUpSeconds / numFrames, double(warmUpAllocations) / numFrames);
+    printf("measured: %9.1f us per frame %9.2f allocations per frame\n", 1000000 * seconds / numFrames, double(allocations) / numFrames);
+    return 0;
+}
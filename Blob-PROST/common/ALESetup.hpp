@@ -0,0 +1,30 @@
+/****************************************************************************************
+ ** Options every ALEInterface of the learner is created with, so that the main program, the
+ ** Hogwild actors and the benchmarks all play the game in the same way.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#ifndef ALE_INTERFACE_H
+#define ALE_INTERFACE_H
+#include <ale_interface.hpp>
+#endif
+#ifndef PARAMETERS_H
+#define PARAMETERS_H
+#include "Parameters.hpp"
+#endif
+
+/**
+ * Sets the options of an ALE and loads the ROM.
+ *
+ * @param int seed the ALE is seeded with 2*seed
+ */
+inline void setUpALE(ALEInterface& ale, Parameters& param, int seed){
+    ale.setFloat("repeat_action_probability", 0.00);
+    ale.setInt("random_seed", 2*seed);
+    ale.setInt("frame_skip", param.getNumStepsPerAction());
+    ale.setInt("max_num_frames_per_episode", param.getEpisodeLength());
+    ale.setBool("color_averaging", true);
+
+    ale.loadROM(param.getRomPath().c_str());
+}
@@ -0,0 +1,129 @@
+/****************************************************************************************
+ ** Hash table from feature indices to the groups they belong to, used by SarsaLearner.
+ ** It is an open-addressing table with linear probing: keys and groups are stored in two
+ ** flat arrays, so a lookup touches one or two cache lines and no node is ever allocated.
+ **
+ ** REMARKS: - Feature indices are non-negative, -1 marks an empty slot.
+ **          - Groups are numbered from 1, 0 means the feature has no group yet. This is
+ **            the same convention unordered_map<long long,long long> had with operator[].
+ **          - Entries are never erased, only added or overwritten.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#include <vector>
+#include <stddef.h>
+
+class FeatureTranslationTable{
+private:
+    std::vector<long long> keys;
+    std::vector<int> groups;
+    size_t numEntries;
+    size_t mask;                    //capacity - 1, the capacity is always a power of 2
+
+    size_t findSlot(long long feature) const{
+        size_t slot = hash(feature) & mask;
+        while (keys[slot] != feature && keys[slot] != -1){
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+public:
+    static size_t hash(long long feature){
+        //Feature indices are very structured, so they are mixed before taking the low bits
+        unsigned long long h = (unsigned long long) feature;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return (size_t) h;
+    }
+
+    FeatureTranslationTable(){
+        clear();
+    }
+    /**
+     * Removes all entries and goes back to the initial capacity.
+     */
+    void clear(){
+        keys.assign(16, -1);
+        groups.assign(16, 0);
+        numEntries = 0;
+        mask = 15;
+    }
+    /**
+     * Changes the capacity to the smallest power of 2 that is at least numSlots and keeps the
+     * table at most half full, moving all entries to their new slots.
+     */
+    void rehash(size_t numSlots){
+        size_t capacity = 16;
+        while (capacity < numSlots || capacity < 2 * numEntries){
+            capacity *= 2;
+        }
+        std::vector<long long> oldKeys(capacity, -1);
+        std::vector<int> oldGroups(capacity, 0);
+        oldKeys.swap(keys);
+        oldGroups.swap(groups);
+        mask = capacity - 1;
+        for (size_t i = 0; i < oldKeys.size(); i++){
+            if (oldKeys[i] != -1){
+                size_t slot = findSlot(oldKeys[i]);
+                keys[slot] = oldKeys[i];
+                groups[slot] = oldGroups[i];
+            }
+        }
+    }
+    /**
+     * Makes room for numFeatures entries, so they can be added without rehashing.
+     */
+    void reserve(size_t numFeatures){
+        if (2 * numFeatures > mask + 1){
+            rehash(2 * numFeatures);
+        }
+    }
+    /**
+     * @return int the group of the feature, 0 if it has none. The table is not modified.
+     */
+    int get(long long feature) const{
+        return groups[findSlot(feature)];
+    }
+    /**
+     * Returns a reference to the group of the feature, adding it with group 0 if it is not
+     * in the table yet. The reference is valid until the next call that adds a feature.
+     */
+    int& findOrInsert(long long feature){
+        if (2 * (numEntries + 1) > mask + 1){
+            rehash(2 * (mask + 1));
+        }
+        size_t slot = findSlot(feature);
+        if (keys[slot] == -1){
+            keys[slot] = feature;
+            numEntries++;
+        }
+        return groups[slot];
+    }
+    void set(long long feature, int group){
+        findOrInsert(feature) = group;
+    }
+    size_t size() const{
+        return numEntries;
+    }
+    /**
+     * The slots are exposed to iterate over all entries, e.g. to save them:
+     * for (size_t slot = 0; slot < table.getCapacity(); slot++) if (table.isOccupied(slot)) ...
+     */
+    size_t getCapacity() const{
+        return mask + 1;
+    }
+    bool isOccupied(size_t slot) const{
+        return keys[slot] != -1;
+    }
+    long long getFeature(size_t slot) const{
+        return keys[slot];
+    }
+    int getGroup(size_t slot) const{
+        return groups[slot];
+    }
+};
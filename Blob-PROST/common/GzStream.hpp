@@ -0,0 +1,146 @@
+/****************************************************************************************
+ ** Streams over zlib's gzFile, used for the check points and the weights files. Written
+ ** with a compression level from 1 to 9 they are gzip files, with level 0 they are written
+ ** as they are, byte for byte what std::ofstream writes. Reading decompresses as the
+ ** stream is consumed, and a file that is not gzip is read as it is, so the same code
+ ** loads compressed and uncompressed files.
+ **
+ ** REMARKS: - The compressed files keep their names, their contents tell whether they are
+ **            compressed, e.g. "file x" or "gzip -t x".
+ **          - Errors of gzwrite set the failbit of the stream, check it after close().
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#include <zlib.h>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class GzStreamBuf : public std::streambuf{
+private:
+    static const int BUFFER_SIZE = 1 << 16;
+    gzFile file;
+    std::vector<char> buffer;
+    bool ok;
+
+    GzStreamBuf(const GzStreamBuf&);
+    GzStreamBuf& operator=(const GzStreamBuf&);
+
+    bool flushBuffer(){
+        int size = pptr() - pbase();
+        if (size > 0){
+            ok = ok && gzwrite(file, pbase(), size) == size;
+            pbump(-size);
+        }
+        return ok;
+    }
+
+protected:
+    int_type overflow(int_type c){
+        if (file == NULL || !flushBuffer()){
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(c, traits_type::eof())){
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    int sync(){
+        return file != NULL && flushBuffer() ? 0 : -1;
+    }
+    int_type underflow(){
+        if (file == NULL){
+            return traits_type::eof();
+        }
+        int size = gzread(file, &buffer[0], buffer.size());
+        if (size <= 0){
+            return traits_type::eof();
+        }
+        setg(&buffer[0], &buffer[0], &buffer[0] + size);
+        return traits_type::to_int_type(*gptr());
+    }
+
+public:
+    GzStreamBuf() : file(NULL), buffer(BUFFER_SIZE), ok(false){}
+    ~GzStreamBuf(){
+        close();
+    }
+    /**
+     * @param int compressionLevel from 1 to 9 to write a gzip file, 0 to write it uncompressed,
+     *        -1 to read it
+     */
+    bool open(const std::string& fileName, int compressionLevel){
+        std::string mode = compressionLevel < 0 ? "rb" : compressionLevel == 0 ? "wbT" : "wb" + std::to_string(compressionLevel);
+        file = gzopen(fileName.c_str(), mode.c_str());
+        ok = file != NULL;
+        if (ok){
+            gzbuffer(file, 1 << 17);
+            if (compressionLevel < 0){
+                setg(&buffer[0], &buffer[0], &buffer[0]);
+            }else{
+                setp(&buffer[0], &buffer[0] + buffer.size());
+            }
+        }
+        return ok;
+    }
+    bool isOpen(){
+        return file != NULL;
+    }
+    /**
+     * @return bool false if something could not be written
+     */
+    bool close(){
+        if (file == NULL){
+            return false;
+        }
+        flushBuffer();
+        ok = gzclose(file) == Z_OK && ok;
+        file = NULL;
+        setg(NULL, NULL, NULL);
+        setp(NULL, NULL);
+        return ok;
+    }
+};
+
+class GzOutputStream : public std::ostream{
+private:
+    GzStreamBuf streamBuf;
+
+public:
+    GzOutputStream(const std::string& fileName, int compressionLevel) : std::ostream(NULL){
+        rdbuf(&streamBuf);
+        if (!streamBuf.open(fileName, compressionLevel)){
+            setstate(std::ios_base::failbit);
+        }
+    }
+    bool is_open(){
+        return streamBuf.isOpen();
+    }
+    void close(){
+        if (!streamBuf.close()){
+            setstate(std::ios_base::failbit);
+        }
+    }
+};
+
+class GzInputStream : public std::istream{
+private:
+    GzStreamBuf streamBuf;
+
+public:
+    GzInputStream(const std::string& fileName) : std::istream(NULL){
+        rdbuf(&streamBuf);
+        if (!streamBuf.open(fileName, -1)){
+            setstate(std::ios_base::failbit);
+        }
+    }
+    bool is_open(){
+        return streamBuf.isOpen();
+    }
+    void close(){
+        streamBuf.close();
+    }
+};
@@ -59,6 +59,19 @@ private:
     int finalNumberOfBlobs;
     int randomNoOp;
     int noOpMax;
+    int blobLabeler;                //0: union-find over pixels, 1: union-find over horizontal runs of equal color, 2: bit planes, see BlobTimeFeatures
+    int weightsLayout;              //0: weights and traces stored [action][group], 1: stored [group][action], padded for SIMD
+    int lazyTraces;                 //whether traces decay through a global step counter instead of one by one
+    int fusedTraceUpdate;           //whether traces are decayed in the same pass that updates the weights
+    int numActors;                  //number of actor threads sharing the weights, Hogwild when greater than 1
+    int numEvalThreads;             //number of threads of the evaluation, which is parallel when greater than 1
+    int pipelinedExtraction;        //whether actions and feature extraction run in a thread overlapping the weight update
+    int numEnvs;                    //number of emulators stepped together by the learner, only without Hogwild
+    int checkPointFormat;           //format of the check points written, 0 for text and 1 for binary
+    int asyncCheckPoint;            //whether check points are written in a thread of their own while learning continues
+    int deltaCheckPoints;           //number of delta check points written between two full ones, 0 to only write full ones
+    int compressionLevel;           //zlib level of the check points and weights files written, 0 to write them uncompressed
+    int labelingThreads;            //threads of the run labeler (BLOB_LABELER=1), each labels a horizontal strip of the screen
     
     std::mt19937 agentRand;
     
@@ -235,6 +248,19 @@ private:
     void setFinalNumberOfBlobs(int a);
     void setRandomNoOp(int a);
     void setNoOpMax(int a);
+    void setBlobLabeler(int a);
+    void setWeightsLayout(int a);
+    void setLazyTraces(int a);
+    void setFusedTraceUpdate(int a);
+    void setNumActors(int a);
+    void setNumEvalThreads(int a);
+    void setPipelinedExtraction(int a);
+    void setNumEnvs(int a);
+    void setCheckPointFormat(int a);
+    void setAsyncCheckPoint(int a);
+    void setDeltaCheckPoints(int a);
+    void setCompressionLevel(int a);
+    void setLabelingThreads(int a);
     
 public:
     /**
@@ -379,4 +405,17 @@ public:
     std::mt19937* getRNG();
     int getRandomNoOp();
     int getNoOpMax();
+    int getBlobLabeler();
+    int getWeightsLayout();
+    int getLazyTraces();
+    int getFusedTraceUpdate();
+    int getNumActors();
+    int getNumEvalThreads();
+    int getPipelinedExtraction();
+    int getNumEnvs();
+    int getCheckPointFormat();
+    int getAsyncCheckPoint();
+    int getDeltaCheckPoints();
+    int getCompressionLevel();
+    int getLabelingThreads();
 };
@@ -0,0 +1,72 @@
+/****************************************************************************************
+ ** Lock-free ring buffer between exactly one producer thread and one consumer thread, used
+ ** to hand actions and extracted features between the learner and the extraction thread.
+ ** The slots are allocated once and written in place: the producer fills getWriteSlot() and
+ ** calls push(), the consumer reads front() and calls pop(). A slot is reused as is, so
+ ** vectors in it keep their capacity and the hand-off does not allocate.
+ **
+ ** REMARKS: - A thread that finds the ring full (producer) or empty (consumer) spins,
+ **            yielding the processor, since the other side is expected to be fast.
+ **          - The capacity is a power of 2.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+template<class T>
+class SPSCRing{
+private:
+    std::vector<T> slots;
+    size_t mask;
+    std::atomic<size_t> head;       //next slot to be read, only written by the consumer
+    char padding[64];               //keeps head and tail in different cache lines
+    std::atomic<size_t> tail;       //next slot to be written, only written by the producer
+
+    SPSCRing(const SPSCRing&);
+    SPSCRing& operator=(const SPSCRing&);
+
+public:
+    /**
+     * @param size_t capacity number of slots, rounded up to a power of 2
+     */
+    SPSCRing(size_t capacity){
+        size_t size = 1;
+        while (size < capacity){
+            size *= 2;
+        }
+        slots.resize(size);
+        mask = size - 1;
+        head = 0;
+        tail = 0;
+    }
+    /**
+     * Producer: waits for a free slot and returns it, it is only visible to the consumer after push().
+     */
+    T& getWriteSlot(){
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        while (currentTail - head.load(std::memory_order_acquire) > mask){
+            std::this_thread::yield();
+        }
+        return slots[currentTail & mask];
+    }
+    void push(){
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    /**
+     * Consumer: waits until there is a slot to be read and returns it, it is valid until pop().
+     */
+    T& front(){
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        while (tail.load(std::memory_order_acquire) == currentHead){
+            std::this_thread::yield();
+        }
+        return slots[currentHead & mask];
+    }
+    void pop(){
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
@@ -0,0 +1,87 @@
+/****************************************************************************************
+ ** Memory for the containers that only live while a frame is processed, used by
+ ** BlobTimeFeatures. Allocating is moving a pointer forward, freeing does nothing and
+ ** reset() makes all the memory available again, so after the first frames, once the
+ ** arena has grown to what a frame needs, the containers no longer touch the heap.
+ ** ArenaAllocator lets the standard containers take their memory from it.
+ **
+ ** REMARKS: - Everything allocated from the arena must be destroyed before reset().
+ **          - A request that does not fit in the current block takes the next one, a new
+ **            block is only allocated when all of them are used, and it is kept.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#include <vector>
+#include <stddef.h>
+
+class ScratchArena{
+private:
+    static const size_t ALIGNMENT = 16;
+    static const size_t MIN_BLOCK_SIZE = 1 << 16;
+    std::vector<std::vector<char> > blocks;
+    size_t currentBlock;
+    size_t offset;                  //first free byte of the current block
+
+    ScratchArena(const ScratchArena&);
+    ScratchArena& operator=(const ScratchArena&);
+
+public:
+    ScratchArena() : currentBlock(0), offset(0){}
+    void* allocate(size_t bytes){
+        bytes = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        while (currentBlock < blocks.size() && offset + bytes > blocks[currentBlock].size()){
+            currentBlock++;
+            offset = 0;
+        }
+        if (currentBlock == blocks.size()){
+            size_t blockSize = blocks.empty() ? MIN_BLOCK_SIZE : 2 * blocks.back().size();
+            while (blockSize < bytes){
+                blockSize *= 2;
+            }
+            //vector<char> memory comes from operator new, which is aligned to at least 16 bytes
+            blocks.push_back(std::vector<char>(blockSize));
+            offset = 0;
+        }
+        void* memory = &blocks[currentBlock][offset];
+        offset += bytes;
+        return memory;
+    }
+    void reset(){
+        currentBlock = 0;
+        offset = 0;
+    }
+    /**
+     * @return size_t total size of the blocks, which only grows
+     */
+    size_t capacity() const{
+        size_t bytes = 0;
+        for (size_t block = 0; block < blocks.size(); block++){
+            bytes += blocks[block].size();
+        }
+        return bytes;
+    }
+};
+
+template<class T>
+class ArenaAllocator{
+public:
+    typedef T value_type;
+    ScratchArena* arena;
+
+    ArenaAllocator(ScratchArena* arena) : arena(arena){}
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena){}
+    T* allocate(size_t n){
+        return (T*) arena->allocate(n * sizeof(T));
+    }
+    void deallocate(T*, size_t){}
+    template<class U>
+    bool operator==(const ArenaAllocator<U>& other) const{
+        return arena == other.arena;
+    }
+    template<class U>
+    bool operator!=(const ArenaAllocator<U>& other) const{
+        return arena != other.arena;
+    }
+};
@@ -0,0 +1,60 @@
+/****************************************************************************************
+ ** Set of K emulators stepped together, used by SarsaLearner with NUM_ENVS > 1.
+ **
+ ** REMARKS: - All methods' high-level comments are in the .hpp file.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#ifndef VECTOR_ENV_H
+#define VECTOR_ENV_H
+#include "VectorEnv.hpp"
+#endif
+#include <string.h>
+
+VectorEnv::VectorEnv(Parameters& param, int numEnvs){
+    for(int env = 0; env < numEnvs; env++){
+        ALEInterface* ale = new ALEInterface(false);
+        setUpALE(*ale, param, param.getSeed() + 1000 * env);
+        ales.push_back(ale);
+    }
+    screenSize = ales[0]->getScreen().height() * ales[0]->getScreen().width();
+    screens.resize((size_t) numEnvs * screenSize);
+    updateScreens();
+}
+
+VectorEnv::~VectorEnv(){
+    for(unsigned int env = 0; env < ales.size(); env++){
+        delete ales[env];
+    }
+}
+
+int VectorEnv::getNumEnvs(){
+    return ales.size();
+}
+
+ALEInterface& VectorEnv::getALE(int env){
+    return *ales[env];
+}
+
+void VectorEnv::updateScreen(int env){
+    memcpy(&screens[(size_t) env * screenSize], ales[env]->getScreen().getArray(), screenSize * sizeof(pixel_t));
+}
+
+void VectorEnv::updateScreens(){
+    for(unsigned int env = 0; env < ales.size(); env++){
+        updateScreen(env);
+    }
+}
+
+const pixel_t* VectorEnv::getScreens(){
+    return &screens[0];
+}
+
+const pixel_t* VectorEnv::getScreen(int env){
+    return &screens[(size_t) env * screenSize];
+}
+
+int VectorEnv::getScreenSize(){
+    return screenSize;
+}
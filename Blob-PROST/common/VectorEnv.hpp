@@ -0,0 +1,56 @@
+/****************************************************************************************
+ ** Set of K emulators stepped together, used by SarsaLearner with NUM_ENVS > 1. Each
+ ** emulator is an ALEInterface of its own, set up with setUpALE as the one of main. After
+ ** the emulators are stepped their screens are copied to a single contiguous buffer,
+ ** screen k right after screen k-1, which is what the batch API of the features reads.
+ **
+ ** REMARKS: - Emulator k is seeded with seed + 1000 * k, the same seeds of the Hogwild actors,
+ **            so emulator 0 is the same as the ALE of a run with a single emulator.
+ **          - The screens in the buffer are only updated by updateScreen(s).
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#ifndef ALE_INTERFACE_H
+#define ALE_INTERFACE_H
+#include <ale_interface.hpp>
+#endif
+#ifndef PARAMETERS_H
+#define PARAMETERS_H
+#include "Parameters.hpp"
+#endif
+#ifndef ALE_SETUP_H
+#define ALE_SETUP_H
+#include "ALESetup.hpp"
+#endif
+#include <vector>
+
+class VectorEnv{
+private:
+    std::vector<ALEInterface*> ales;
+    std::vector<pixel_t> screens;           //numEnvs * screenSize pixels
+    int screenSize;
+
+    VectorEnv(const VectorEnv&);
+    VectorEnv& operator=(const VectorEnv&);
+
+public:
+    /**
+     * @param int numEnvs number of emulators, emulator k is seeded with param.getSeed() + 1000 * k
+     */
+    VectorEnv(Parameters& param, int numEnvs);
+    ~VectorEnv();
+    int getNumEnvs();
+    ALEInterface& getALE(int env);
+    /**
+     * Copies the current screen of the emulator to its place in the buffer.
+     */
+    void updateScreen(int env);
+    void updateScreens();
+    /**
+     * @return pixel_t* the buffer with the screens of all emulators, as in ALEScreen::getArray()
+     */
+    const pixel_t* getScreens();
+    const pixel_t* getScreen(int env);
+    int getScreenSize();
+};
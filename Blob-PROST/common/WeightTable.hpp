@@ -0,0 +1,200 @@
+/****************************************************************************************
+ ** Storage for one value per (action, group), used by SarsaLearner for the weights and the
+ ** eligibility traces (WeightTable, with floats) and for the steps at which lazy traces were
+ ** set (with ints). All values are in a single 64-byte aligned buffer, in one of two layouts:
+ **  - action-major (0): the values of one action for all groups are contiguous, as in the
+ **    vector<vector<float> > [action][group] it replaces.
+ **  - group-major (1): the values of all actions for one group are contiguous, padded to a
+ **    multiple of 8 floats, so they can be read with a few SIMD loads.
+ ** Element (action, group) is at data[action*actionStride + group*groupStride] in both cases.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <assert.h>
+#include <vector>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+template<class T>
+class ActionGroupTable{
+private:
+    T* data;
+    int numActions;
+    int groupMajor;
+    int paddedActions;              //values per group in the group-major layout
+    long long numGroups;
+    long long capacity;             //number of groups allocated
+    long long actionStride, groupStride;
+
+    void reallocate(long long newCapacity){
+        T* newData = NULL;
+        size_t numValues = (size_t) newCapacity * (groupMajor ? paddedActions : numActions);
+        if (posix_memalign((void**) &newData, 64, std::max(numValues, (size_t) 1) * sizeof(T)) != 0){
+            abort();
+        }
+        memset(newData, 0, numValues * sizeof(T));
+        if (data != NULL){
+            if (groupMajor){
+                memcpy(newData, data, (size_t) numGroups * paddedActions * sizeof(T));
+            }else{
+                //Every action row moves, since the rows are newCapacity apart now
+                for (int a = 0; a < numActions; a++){
+                    memcpy(newData + a * newCapacity, data + a * capacity, (size_t) numGroups * sizeof(T));
+                }
+            }
+            free(data);
+        }
+        data = newData;
+        capacity = newCapacity;
+        actionStride = groupMajor ? 1 : capacity;
+        groupStride = groupMajor ? paddedActions : 1;
+    }
+
+    ActionGroupTable(const ActionGroupTable&);
+    ActionGroupTable& operator=(const ActionGroupTable&);
+
+public:
+    static const int MAX_ACTIONS = 32;  //ALE has 18 actions, this bounds the SIMD accumulators
+
+    ActionGroupTable(){
+        data = NULL;
+        numActions = 0;
+        groupMajor = 0;
+        paddedActions = 0;
+        numGroups = 0;
+        capacity = 0;
+        actionStride = groupStride = 0;
+    }
+    ~ActionGroupTable(){
+        free(data);
+    }
+    /**
+     * Sets the number of actions and the layout, removing all groups.
+     * @param int groupMajor 0 for the action-major layout, 1 for the group-major one
+     */
+    void init(int numActions, int groupMajor){
+        assert(numActions <= MAX_ACTIONS);
+        free(data);
+        data = NULL;
+        this->numActions = numActions;
+        this->groupMajor = groupMajor;
+        this->paddedActions = (numActions + 7) / 8 * 8;
+        numGroups = 0;
+        reallocate(1024);
+    }
+    /**
+     * Exchanges the contents of the two tables, without copying the values.
+     */
+    void swap(ActionGroupTable& other){
+        std::swap(data, other.data);
+        std::swap(numActions, other.numActions);
+        std::swap(groupMajor, other.groupMajor);
+        std::swap(paddedActions, other.paddedActions);
+        std::swap(numGroups, other.numGroups);
+        std::swap(capacity, other.capacity);
+        std::swap(actionStride, other.actionStride);
+        std::swap(groupStride, other.groupStride);
+    }
+    T& operator()(int action, long long group){
+        return data[action * actionStride + group * groupStride];
+    }
+    /**
+     * @return pointer to the paddedActions values of the group, only for the group-major layout.
+     *         It is 32-byte aligned and the padding values are always 0.
+     */
+    const T* getGroup(long long group) const{
+        return data + group * paddedActions;
+    }
+    /**
+     * Changes the number of groups, the new ones have all values equal to 0.
+     */
+    void resize(long long newNumGroups){
+        if (newNumGroups > capacity){
+            reallocate(std::max(newNumGroups, 2 * capacity));
+        }
+        for (long long g = newNumGroups; g < numGroups; g++){
+            for (int a = 0; a < numActions; a++){
+                (*this)(a, g) = 0;
+            }
+        }
+        numGroups = newNumGroups;
+    }
+    /**
+     * Appends a group with all values equal to 0.
+     */
+    void addGroup(){
+        resize(numGroups + 1);
+    }
+    /**
+     * Appends a group with the same values of an existing one.
+     */
+    void addGroupCopy(long long group){
+        resize(numGroups + 1);
+        for (int a = 0; a < numActions; a++){
+            (*this)(a, numGroups - 1) = (*this)(a, group);
+        }
+    }
+    /**
+     * Computes, for every action, the sum over the active groups of the group value times
+     * multiplier(group). Each action is summed in the order of the groups in both layouts,
+     * so the result does not depend on the layout. In the group-major layout all the values
+     * of a group are read with paddedActions/4 SIMD loads. Only for T = float.
+     *
+     * @param vector<long long>& activeGroups indices of the groups to be summed
+     * @param Multiplier multiplier function from group index to the float it is multiplied by
+     * @param float* sums receives numActions values
+     */
+    template<class Multiplier>
+    void sumGroups(const std::vector<long long>& activeGroups, Multiplier multiplier, float* sums) const{
+        size_t numActive = activeGroups.size();
+#ifdef __SSE__
+        if (groupMajor){
+            int numChunks = paddedActions / 4;
+            __m128 chunkSums[MAX_ACTIONS / 4];
+            for (int k = 0; k < numChunks; k++){
+                chunkSums[k] = _mm_setzero_ps();
+            }
+            for (size_t i = 0; i < numActive; i++){
+                const float* groupValues = getGroup(activeGroups[i]);
+                __m128 factor = _mm_set1_ps((float) multiplier(activeGroups[i]));
+                for (int k = 0; k < numChunks; k++){
+                    chunkSums[k] = _mm_add_ps(chunkSums[k], _mm_mul_ps(_mm_load_ps(groupValues + 4 * k), factor));
+                }
+            }
+            float paddedSums[MAX_ACTIONS] __attribute__((aligned(16)));
+            for (int k = 0; k < numChunks; k++){
+                _mm_store_ps(paddedSums + 4 * k, chunkSums[k]);
+            }
+            memcpy(sums, paddedSums, numActions * sizeof(float));
+            return;
+        }
+#endif
+        for (int a = 0; a < numActions; a++){
+            const float* actionValues = data + a * actionStride;
+            float sum = 0;
+            for (size_t i = 0; i < numActive; i++){
+                sum = sum + actionValues[activeGroups[i] * groupStride] * (float) multiplier(activeGroups[i]);
+            }
+            sums[a] = sum;
+        }
+    }
+    long long getNumGroups() const{
+        return numGroups;
+    }
+    int getNumActions() const{
+        return numActions;
+    }
+    int getPaddedActions() const{
+        return paddedActions;
+    }
+    int isGroupMajor() const{
+        return groupMajor;
+    }
+};
+
+typedef ActionGroupTable<float> WeightTable;
@@ -0,0 +1,90 @@
+/****************************************************************************************
+ ** Threads that are created once and then run a task on request, used by BlobTimeFeatures
+ ** to label the strips of a screen in parallel without starting threads at every frame.
+ ** run(task) calls task(part) for every part from 0 to numThreads-1, part 0 on the calling
+ ** thread and each other part on a thread of the pool, and returns when all have finished.
+ **
+ ** REMARKS: - Between tasks the threads spin for a while, yielding the processor, since the
+ **            next frame usually comes soon, and then sleep until the next task.
+ **          - run() must not be called by more than one thread at a time.
+ **
+ ** Author: Marlos C. Machado
+ ***************************************************************************************/
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool{
+private:
+    static const int SPIN_ROUNDS = 2000;
+    std::vector<std::thread> threads;
+    const std::function<void(int)>* task;
+    std::atomic<long long> generation;  //number of tasks started, a thread runs a task when it changes
+    std::atomic<int> pending;           //parts of the current task not finished yet
+    bool stopping;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+
+    void work(int part){
+        long long seen = 0;
+        while (true){
+            for (int round = 0; round < SPIN_ROUNDS && generation.load(std::memory_order_acquire) == seen; round++){
+                std::this_thread::yield();
+            }
+            if (generation.load(std::memory_order_acquire) == seen){
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock, [&]{ return generation.load(std::memory_order_acquire) != seen; });
+            }
+            seen = generation.load(std::memory_order_acquire);
+            if (stopping){
+                return;
+            }
+            (*task)(part);
+            pending.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+public:
+    /**
+     * @param int numThreads parts of each task, including the one run by the caller
+     */
+    WorkerPool(int numThreads) : task(NULL), generation(0), pending(0), stopping(false){
+        for (int part = 1; part < numThreads; part++){
+            threads.push_back(std::thread(&WorkerPool::work, this, part));
+        }
+    }
+    ~WorkerPool(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            generation++;
+        }
+        wakeUp.notify_all();
+        for (size_t thread = 0; thread < threads.size(); thread++){
+            threads[thread].join();
+        }
+    }
+    int getNumThreads() const{
+        return threads.size() + 1;
+    }
+    void run(const std::function<void(int)>& task){
+        this->task = &task;
+        pending.store(threads.size(), std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            generation++;
+        }
+        wakeUp.notify_all();
+        task(0);
+        while (pending.load(std::memory_order_acquire) > 0){
+            std::this_thread::yield();
+        }
+    }
+};
@@ -0,0 +1,63 @@
+/****************************************************************************************
+** Converts a check point of SarsaLearner between the text and the binary formats (see
+** common/CheckPoint.hpp), e.g. to move a running job to binary check points. The format of
+** the input is detected, the output has the other one. The text format does not have the
+** number of actions, it must be given when converting from text, it is the number of
+** actions of the game (the minimal action set with USE_MIN_ACTIONS, otherwise 18).
+** Given a delta check point after the input, it is applied to it and the result is written as
+** a full binary check point, as the learner itself does when it loads them.
+**
+** Usage: ./convertCheckPoint <input check point> <output check point> [numActions]
+**        ./convertCheckPoint <full check point> <delta check point> <output check point> [numActions]
+**
+** Author: Marlos C. Machado
+***************************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include "common/CheckPoint.hpp"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+using namespace std;
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        printf("Usage: %s <input check point> <output check point> [numActions]\n", argv[0]);
+        printf("       %s <full check point> <delta check point> <output check point> [numActions]\n", argv[0]);
+        return 1;
+    }
+    string inputName = argv[1];
+    string outputName = argv[2];
+    int numActions = argc > 3 ? atoi(argv[3]) : 18;
+
+    CheckPoint checkPoint, delta;
+    string error;
+    bool applyDelta = argc > 3 && CheckPointIO::loadDelta(argv[2], delta, error);
+    if(applyDelta){
+        outputName = argv[3];
+        numActions = argc > 4 ? atoi(argv[4]) : 18;
+    }
+    bool toBinary = !CheckPointIO::isBinary(inputName);
+    bool loaded = toBinary ? CheckPointIO::loadText(inputName, numActions, checkPoint, error) : CheckPointIO::loadBinary(inputName, checkPoint, error);
+    if(!loaded){
+        printf("Unable to load the check point: %s\n", error.c_str());
+        return 1;
+    }
+    if(applyDelta){
+        if(!CheckPointIO::applyDelta(checkPoint, delta, error)){
+            printf("Unable to apply the delta check point: %s\n", error.c_str());
+            return 1;
+        }
+        toBinary = true;
+    }
+    bool saved = toBinary ? CheckPointIO::saveBinary(outputName, checkPoint) : CheckPointIO::saveText(outputName, checkPoint);
+    if(!saved){
+        printf("Unable to write %s\n", outputName.c_str());
+        return 1;
+    }
+    printf("%s check point with %lld groups, %zu features and %d actions written to %s\n",
+           toBinary ? "Binary" : "Text", checkPoint.getNumGroups(), checkPoint.translationFeatures.size(), checkPoint.numActions, outputName.c_str());
+    return 0;
+}
@@ -17,11 +17,16 @@
 #include <assert.h>
 #include <algorithm>
 #include <math.h>
+#include <stdio.h>
+#include <string.h>
 #include <unordered_set>
 
 using namespace std;
 //using google::dense_hash_map;
 
+//Words of a row of a bit plane, for the 160 columns of the screen
+static const int PLANE_ROW_WORDS = 3;
+
 
 BlobTimeFeatures::BlobTimeFeatures(Parameters *param){
     this->param = param;
@@ -66,23 +71,24 @@ BlobTimeFeatures::BlobTimeFeatures(Parameters *param){
         //baseThreePoint.push_back(baseThreePoint.back()+get<0>(numOffsets[index]) * get<1>(numOffsets[index])* (1+numColors) * numColors/2 * numColors* get<0>(numOffsets[index])*get<1>(numOffsets[index]));
     }
     
-    //set up table to prevent repetitive features
+    //set up table to prevent repetitive features, the offsets of all resolutions one after the other
+    long long numStamps = 0;
     for (int index=0;index<numResolutions;++index){
-        changed.push_back(vector<tuple<int,int> >());
-        bproExistence.push_back(vector<vector<bool> >());
-        bproExistence[index].resize(get<0>(numOffsets[index]));
-        for (int i=0;i<get<0>(numOffsets[index]);++i){
-            bproExistence[index][i].resize(get<1>(numOffsets[index]));
-            for (int j=0;j<get<1>(numOffsets[index]);++j){
-                bproExistence[index][i][j]=true;
-            }
-        }
+        bproStampBase.push_back(numStamps);
+        numStamps += get<0>(numOffsets[index])*get<1>(numOffsets[index]);
         //threePointExistence.push_back(dense_hash_map<long long,int>());
         //threePointExistence.back().set_empty_key(numThreePointOffsets+1);
         //threePointExistence.back().resize(100000);
     }
+    bproStamps.resize(numStamps);
+    cellStamps.resize(numResolutions);
+    for (int index=0;index<numResolutions;++index){
+        numCellColumns.push_back(159/get<1>(resolutions[index])+1);
+        cellStamps[index].resize((209/get<0>(resolutions[index])+1)*numCellColumns[index]);
+    }
     
     neighborSize = param->getNeighborSize();
+    blobLabeler = param->getBlobLabeler();
     vector<tuple<int,int> > fullNeighborOffsets;
     for (int xDelta=-neighborSize;xDelta<0;++xDelta){
         for (int yDelta=-neighborSize;yDelta<=neighborSize;++yDelta){
@@ -121,37 +127,72 @@ BlobTimeFeatures::BlobTimeFeatures(Parameters *param){
         }
     }
     previousBlobs.clear();
+    
+    screenPixels.resize(210*160);
+    for (int color=0;color<numColors;++color){
+        blobIndices.push_back(BlobIndexSet(ArenaAllocator<int>(&blobIndexArena)));
+    }
+    basicStamps.resize(numBasicFeatures);
+    labelingPool = NULL;
+    if (blobLabeler==1){
+        runs.resize(210*160);
+        runBlobs.resize(210*160);
+        rowRunStart.resize(210);
+        rowRunEnd.resize(210);
+        int numStrips = max(1,min(param->getLabelingThreads(),210));
+        for (int strip=0;strip<=numStrips;++strip){
+            stripFirstRow.push_back(strip*210/numStrips);
+        }
+        stripRunEnd.resize(numStrips);
+        if (numStrips>1){
+            labelingPool = new WorkerPool(numStrips);
+            labelStripTask = [this](int strip){ labelStrip(strip); };
+        }
+    }else if (param->getLabelingThreads()>1){
+        fprintf(stderr, "Warning: LABELING_THREADS = %d is ignored, only BLOB_LABELER = 1 labels the screen in strips.\n", param->getLabelingThreads());
+    }
+    if (blobLabeler==2){
+        colorPlanes.assign(numColors*210*PLANE_ROW_WORDS,0);
+        dilatedPlane.resize(210*PLANE_ROW_WORDS);
+        planeColors.assign((numColors+63)/64,0);
+        planeRowUp.resize(numColors);
+        planeRowDown.resize(numColors);
+    }
 }
 
 BlobTimeFeatures::~BlobTimeFeatures(){
     delete fullNeighbors;
     delete extraNeighbors;
+    delete labelingPool;
 }
 
-void BlobTimeFeatures::getBlobs(const ALEScreen &screen){
+void BlobTimeFeatures::getBlobs(const pixel_t* screen){
     int screenWidth = 160;
     int screenHeight = 210;
     
-    
-    vector<int> screenPixels(screenHeight*screenWidth,-1);
-    
-    vector<Disjoint_Set_Element> disjoint_set;
-    vector<unordered_set<int> > blobIndices(numColors,unordered_set<int>());
-    vector<int> route;
+    //The sets of the previous frame are replaced by empty ones before their memory is reused,
+    //the blobs are listed in the same order as with sets created for each frame
+    for (int color=0;color<numColors;++color){
+        BlobIndexSet(ArenaAllocator<int>(&blobIndexArena)).swap(blobIndices[color]);
+    }
+    blobIndexArena.reset();
+    disjoint_set.clear();
     
     vector<vector<vector<unsigned short> > >* neighbors;
     
     for (int x=0;x<screenHeight;x++){
         for (int y=0;y<screenWidth;y++){
-            int color = screen.get(x,y);
+            int color = screen[x*screenWidth+y];
             color = color >>colorMultiplier;
-            if (y>0 && color == screen.get(x,y-1)>>colorMultiplier){
+            if (y>0 && color == screen[x*screenWidth+y-1]>>colorMultiplier){
                 neighbors = extraNeighbors;
             }else{
                 neighbors = fullNeighbors;
             }
             unsigned short currentIndex = x*screenWidth + y;
-            int currentRoot = screenPixels[currentIndex];
+            //screenPixels is only read at neighbors, which come before the current pixel, so it
+            //does not need to be reset between frames
+            int currentRoot = -1;
             
             for (auto it=neighbors->at(x).at(y).begin();it!=neighbors->at(x).at(y).end();++it){
                 int neighborRoot = screenPixels[*it];
@@ -230,15 +271,372 @@ void BlobTimeFeatures::getBlobs(const ALEScreen &screen){
     }
 }
 
+//Same blobs as getBlobs, but the union-find works on horizontal runs of equal color instead of
+//on single pixels. Two runs of the same color are connected when they are at most neighborSize
+//rows apart and their column intervals are at most neighborSize columns apart, which is exactly
+//the reach of the fullNeighbors lists. With LABELING_THREADS > 1 the strips are labeled in parallel
+//and then the runs of the first neighborSize rows of each strip are merged with the ones of the
+//rows above it. The root of a blob is its first run in raster order whatever the order of the
+//merges, so the blobs are the same with any number of strips.
+void BlobTimeFeatures::getBlobsFromRuns(const pixel_t* screen){
+    labelingScreen = screen;
+    int numStrips = stripRunEnd.size();
+    if (labelingPool==NULL){
+        labelStrip(0);
+    }else{
+        labelingPool->run(labelStripTask);
+    }
+    for (int strip=1;strip<numStrips;++strip){
+        int firstRow = stripFirstRow[strip];
+        for (int x=firstRow;x<stripFirstRow[strip+1] && x<firstRow+neighborSize;x++){
+            for (int rowDelta=x-firstRow+1;rowDelta<=neighborSize && x-rowDelta>=0;++rowDelta){
+                mergeRowRuns(x,x-rowDelta);
+            }
+        }
+    }
+    
+    //get all the blobs, roots are visited in raster order
+    for (int strip=0;strip<numStrips;++strip){
+        for (int index=stripFirstRow[strip]*160;index<stripRunEnd[strip];++index){
+            if (runBlobs[index].parent==index){
+                int color = runBlobs[index].color;
+                int x = (runBlobs[index].rowUp+runBlobs[index].rowDown)/2;
+                int y = (runBlobs[index].columnLeft+runBlobs[index].columnRight)/2;
+                if (blobs[color].size()==0){
+                    blobActiveColors.push_back(color);
+                }
+                blobs[color].push_back(make_tuple(x,y));
+            }
+        }
+    }
+    sort(blobActiveColors.begin(),blobActiveColors.end());
+}
+
+void BlobTimeFeatures::labelStrip(int strip){
+    int screenWidth = 160;
+    const pixel_t* screen = labelingScreen;
+    int firstRow = stripFirstRow[strip];
+    
+    //a row has at most screenWidth runs
+    int numRuns = firstRow*screenWidth;
+    for (int x=firstRow;x<stripFirstRow[strip+1];x++){
+        rowRunStart[x] = numRuns;
+        int y = 0;
+        while (y<screenWidth){
+            Run_Element& run = runs[numRuns];
+            run.color = screen[x*screenWidth+y]>>colorMultiplier;
+            run.columnLeft = y;
+            while (y+1<screenWidth && screen[x*screenWidth+y+1]>>colorMultiplier == run.color){
+                y++;
+            }
+            run.columnRight = y;
+            
+            Disjoint_Set_Element& element = runBlobs[numRuns];
+            element.columnLeft = run.columnLeft; element.columnRight = run.columnRight;
+            element.rowUp = x; element.rowDown = x;
+            element.size = run.columnRight-run.columnLeft+1;
+            element.parent = numRuns;
+            element.color = run.color;
+            numRuns++;
+            y++;
+        }
+        rowRunEnd[x] = numRuns;
+        
+        for (int current=rowRunStart[x];current<rowRunEnd[x];++current){
+            //runs in the same row: the closest one of the same color is enough, the others
+            //within reach were already connected to it
+            for (int other=current-1;other>=rowRunStart[x] && runs[other].columnRight+neighborSize>=runs[current].columnLeft;--other){
+                if (runs[other].color==runs[current].color){
+                    mergeRuns(other,current);
+                    break;
+                }
+            }
+        }
+        for (int rowDelta=1;rowDelta<=neighborSize && x-rowDelta>=firstRow;++rowDelta){
+            mergeRowRuns(x,x-rowDelta);
+        }
+    }
+    stripRunEnd[strip] = numRuns;
+}
+
+void BlobTimeFeatures::mergeRowRuns(int row, int otherRow){
+    int other = rowRunStart[otherRow];
+    int otherEnd = rowRunEnd[otherRow];
+    for (int current=rowRunStart[row];current<rowRunEnd[row];++current){
+        while (other<otherEnd && runs[other].columnRight+neighborSize<runs[current].columnLeft){
+            other++;
+        }
+        for (int candidate=other;candidate<otherEnd && runs[candidate].columnLeft<=runs[current].columnRight+neighborSize;++candidate){
+            if (runs[candidate].color==runs[current].color){
+                mergeRuns(candidate,current);
+            }
+        }
+    }
+}
+
+//ORs into a row of a bit plane the row shifted shift columns to the right, columns past 159 are dropped.
+//Words are written from the last one, so the words read are still the original ones.
+static void orShiftedRow(unsigned long long* row, int shift){
+    int wordShift = shift/64;
+    int bitShift = shift%64;
+    for (int word=PLANE_ROW_WORDS-1;word>=wordShift;--word){
+        int source = word-wordShift;
+        unsigned long long shifted = row[source]<<bitShift;
+        if (bitShift>0 && source>0){
+            shifted |= row[source-1]>>(64-bitShift);
+        }
+        row[word] |= shifted;
+    }
+    row[PLANE_ROW_WORDS-1] &= (1ULL<<(160-64*(PLANE_ROW_WORDS-1)))-1;
+}
+
+//Sets the bits of the columns from columnLeft to columnRight of a row of a bit plane
+static void setPlaneColumns(unsigned long long* row, int columnLeft, int columnRight){
+    for (int word=columnLeft/64;word<=columnRight/64;++word){
+        int first = max(columnLeft-64*word,0);
+        int last = min(columnRight-64*word,63);
+        row[word] |= (~0ULL>>(63-last+first))<<first;
+    }
+}
+
+//First column from the given one whose bit is set (or clear, if set is false), 160 if there is none
+static int nextPlaneColumn(const unsigned long long* row, int column, bool set){
+    while (column<160){
+        int word = column/64;
+        unsigned long long bits = set ? row[word] : ~row[word];
+        bits &= ~0ULL<<(column%64);
+        if (bits){
+            return min(word*64+__builtin_ctzll(bits),160);
+        }
+        column = (word+1)*64;
+    }
+    return 160;
+}
+
+//Rows firstRow to lastRow of dilatedPlane become the ones of the plane with every pixel grown into a
+//square of neighborSize by neighborSize pixels, to its right and below it, the plane has no pixels
+//in the rows between lastRow-neighborSize+2 and lastRow. The covered width (and then height) doubles
+//at each step, so the cost grows with the logarithm of neighborSize.
+void BlobTimeFeatures::dilatePlane(const unsigned long long* plane, int firstRow, int lastRow){
+    unsigned long long* dilated = &dilatedPlane[0];
+    memcpy(dilated+firstRow*PLANE_ROW_WORDS,plane+firstRow*PLANE_ROW_WORDS,(lastRow-firstRow+1)*PLANE_ROW_WORDS*sizeof(unsigned long long));
+    for (int width=1;width<neighborSize;){
+        int shift = min(width,neighborSize-width);
+        for (int x=firstRow;x<=lastRow;++x){
+            orShiftedRow(dilated+x*PLANE_ROW_WORDS,shift);
+        }
+        width += shift;
+    }
+    for (int height=1;height<neighborSize;){
+        int shift = min(height,neighborSize-height);
+        for (int x=lastRow;x>=firstRow+shift;--x){
+            for (int word=0;word<PLANE_ROW_WORDS;++word){
+                dilated[x*PLANE_ROW_WORDS+word] |= dilated[(x-shift)*PLANE_ROW_WORDS+word];
+            }
+        }
+        height += shift;
+    }
+}
+
+//Same blobs as getBlobsFromRuns, found one color at a time on a bit plane of its pixels. Two pixels
+//are in the same blob when a chain of pixels at most neighborSize rows and columns apart links them.
+//With each pixel grown into a neighborSize by neighborSize square, two squares touch, diagonals
+//included, exactly when their pixels are that close, so the blobs are the 8-connected components of
+//the dilated plane, which are labeled with a union-find over its runs. The bounding box of a blob is
+//the one of its original pixels. Only the rows a color reaches are processed. Assumes NEIGHBOR_SIZE
+//of at least 1.
+void BlobTimeFeatures::getBlobsFromBitPlanes(const pixel_t* screen){
+    int screenWidth = 160;
+    int screenHeight = 210;
+    
+    for (int x=0;x<screenHeight;x++){
+        int y = 0;
+        while (y<screenWidth){
+            int color = screen[x*screenWidth+y]>>colorMultiplier;
+            int columnLeft = y;
+            while (y+1<screenWidth && screen[x*screenWidth+y+1]>>colorMultiplier == color){
+                y++;
+            }
+            setPlaneColumns(&colorPlanes[(color*screenHeight+x)*PLANE_ROW_WORDS],columnLeft,y);
+            if (!(planeColors[color/64]>>(color%64) & 1)){
+                planeColors[color/64] |= 1ULL<<(color%64);
+                planeRowUp[color] = x;
+            }
+            planeRowDown[color] = x;
+            y++;
+        }
+    }
+    
+    //colors in increasing order, as blobActiveColors must be
+    for (int colorWord=0;colorWord<planeColors.size();++colorWord){
+        while (planeColors[colorWord]){
+            int color = colorWord*64+__builtin_ctzll(planeColors[colorWord]);
+            planeColors[colorWord] &= planeColors[colorWord]-1;
+            unsigned long long* plane = &colorPlanes[color*screenHeight*PLANE_ROW_WORDS];
+            int firstRow = planeRowUp[color];
+            int lastRow = min(planeRowDown[color]+neighborSize-1,screenHeight-1);
+            dilatePlane(plane,firstRow,lastRow);
+            
+            //rowRunStart[x-firstRow] is the first run of row x
+            runs.clear();
+            runBlobs.clear();
+            rowRunStart.clear();
+            for (int x=firstRow;x<=lastRow;x++){
+                rowRunStart.push_back(runs.size());
+                const unsigned long long* row = &dilatedPlane[x*PLANE_ROW_WORDS];
+                int y = nextPlaneColumn(row,0,true);
+                while (y<screenWidth){
+                    Run_Element run;
+                    run.color = color;
+                    run.columnLeft = y;
+                    y = nextPlaneColumn(row,y,false);
+                    run.columnRight = y-1;
+                    
+                    //the bounding box is filled with the original pixels below
+                    Disjoint_Set_Element element;
+                    element.columnLeft = screenWidth; element.columnRight = -1;
+                    element.rowUp = screenHeight; element.rowDown = -1;
+                    element.size = 0;
+                    element.parent = runs.size();
+                    element.color = color;
+                    runs.push_back(run);
+                    runBlobs.push_back(element);
+                    y = nextPlaneColumn(row,y,true);
+                }
+                
+                //runs of the previous row that touch the current one, diagonals included
+                if (x>firstRow){
+                    int other = rowRunStart[x-firstRow-1];
+                    int otherEnd = rowRunStart[x-firstRow];
+                    for (int current=rowRunStart[x-firstRow];current<runs.size();++current){
+                        while (other<otherEnd && runs[other].columnRight+1<runs[current].columnLeft){
+                            other++;
+                        }
+                        for (int candidate=other;candidate<otherEnd && runs[candidate].columnLeft<=runs[current].columnRight+1;++candidate){
+                            mergeRuns(candidate,current);
+                        }
+                    }
+                }
+            }
+            
+            //every run of original pixels is inside the run of the dilated plane that covers it
+            for (int x=firstRow;x<=planeRowDown[color];x++){
+                const unsigned long long* row = &plane[x*PLANE_ROW_WORDS];
+                int run = rowRunStart[x-firstRow];
+                int y = nextPlaneColumn(row,0,true);
+                while (y<screenWidth){
+                    int columnLeft = y;
+                    y = nextPlaneColumn(row,y,false);
+                    while (runs[run].columnRight<columnLeft){
+                        run++;
+                    }
+                    auto root = &runBlobs[findRunRoot(run)];
+                    root->rowUp = min(root->rowUp,x);
+                    root->rowDown = max(root->rowDown,x);
+                    root->columnLeft = min(root->columnLeft,columnLeft);
+                    root->columnRight = max(root->columnRight,y-1);
+                    root->size += y-columnLeft;
+                    y = nextPlaneColumn(row,y,true);
+                }
+            }
+            memset(plane+firstRow*PLANE_ROW_WORDS,0,(planeRowDown[color]-firstRow+1)*PLANE_ROW_WORDS*sizeof(unsigned long long));
+            
+            //roots are visited in raster order, the first run of a blob starts at its first pixel
+            blobActiveColors.push_back(color);
+            for (int index=0;index<runBlobs.size();++index){
+                if (runBlobs[index].parent==index){
+                    int x = (runBlobs[index].rowUp+runBlobs[index].rowDown)/2;
+                    int y = (runBlobs[index].columnLeft+runBlobs[index].columnRight)/2;
+                    blobs[color].push_back(make_tuple(x,y));
+                }
+            }
+        }
+    }
+}
+
+int BlobTimeFeatures::findRunRoot(int index){
+    while (runBlobs[index].parent!=index){
+        runBlobs[index].parent = runBlobs[runBlobs[index].parent].parent;
+        index = runBlobs[index].parent;
+    }
+    return index;
+}
+
+//The root is always the run that comes first in raster order and it keeps the blob bounding box.
+void BlobTimeFeatures::mergeRuns(int first, int second){
+    int firstRoot = findRunRoot(first);
+    int secondRoot = findRunRoot(second);
+    if (firstRoot==secondRoot){
+        return;
+    }
+    if (secondRoot<firstRoot){
+        swap(firstRoot,secondRoot);
+    }
+    auto root = &runBlobs[firstRoot];
+    auto other = &runBlobs[secondRoot];
+    other->parent = firstRoot;
+    root->rowUp = min(root->rowUp,other->rowUp);
+    root->rowDown = max(root->rowDown,other->rowDown);
+    root->columnLeft = min(root->columnLeft,other->columnLeft);
+    root->columnRight = max(root->columnRight,other->columnRight);
+    root->size += other->size;
+}
+
+//Position of a feature of a pair of colors in the order the pairs of blobs and then the resolutions give
+//them, a color has fewer than 2^16 blobs
+static long long pendingKey(int firstBlob, int secondBlob, int resolution, int numResolutions){
+    return (((long long)firstBlob<<16)+secondBlob)*numResolutions+resolution;
+}
+
+void BlobTimeFeatures::getBlobCells(){
+    if (blobCells.size()<numResolutions){
+        blobCells.resize(numResolutions);
+    }
+    for (int index=0;index<numResolutions;++index){
+        if (blobCells[index].size()<numColors){
+            blobCells[index].resize(numColors);
+        }
+        for (int i=0;i<blobActiveColors.size();++i){
+            int color = blobActiveColors[i];
+            vector<Cell_Element>& cells = blobCells[index][color];
+            cells.clear();
+            cellStamps[index].clear();
+            for (int blob=0;blob<blobs[color].size();++blob){
+                Cell_Element cell;
+                cell.row = get<0>(blobs[color][blob])/get<0>(resolutions[index]);
+                cell.column = get<1>(blobs[color][blob])/get<1>(resolutions[index]);
+                cell.firstBlob = blob;
+                if (cellStamps[index].insert(cell.row*numCellColumns[index]+cell.column)){
+                    cells.push_back(cell);
+                }
+            }
+        }
+    }
+}
+
+//The offset of a pair of tiles is first found for the pair of their first blobs, as the tiles are in
+//the order of their first blobs the features of a resolution are found in the order of the pairs of blobs
+void BlobTimeFeatures::addPendingFeatures(vector<long long>& features){
+    if (numResolutions>1){
+        sort(pendingFeatures.begin(),pendingFeatures.end());
+    }
+    for (auto it=pendingFeatures.begin();it!=pendingFeatures.end();++it){
+        features.push_back(it->second);
+    }
+    pendingFeatures.clear();
+}
+
 void BlobTimeFeatures::addRelativeFeaturesIndices(vector<long long>& features){
     for (int index1=0;index1<blobActiveColors.size();++index1){
         int c1 = blobActiveColors[index1];
-        for (auto k=blobs[c1].begin();k!=blobs[c1].end();++k){
-            for (auto h=blobs[c1].begin();h!=blobs[c1].end();++h){
-                
-                for (int index=0;index<numResolutions;++index){
-                    int rowDelta = get<0>(*k)/get<0>(resolutions[index])-get<0>(*h)/get<0>(resolutions[index]);
-                    int columnDelta = get<1>(*k)/get<1>(resolutions[index])-get<1>(*h)/get<1>(resolutions[index]);
+        for (int index=0;index<numResolutions;++index){
+            int numColumnOffsets = get<1>(numOffsets[index]);
+            long long pairBase = baseBpro[index]+(long long)(numColors+numColors-c1+1)*c1/2*get<0>(numOffsets[index])*numColumnOffsets;
+            vector<Cell_Element>& cells = blobCells[index][c1];
+            for (auto k=cells.begin();k!=cells.end();++k){
+                for (auto h=cells.begin();h!=cells.end();++h){
+                    int rowDelta = k->row-h->row;
+                    int columnDelta = k->column-h->column;
                     bool newBproFeature = false;
                     if (rowDelta>0){
                         newBproFeature = true;
@@ -247,59 +645,42 @@ void BlobTimeFeatures::addRelativeFeaturesIndices(vector<long long>& features){
                     }
                     rowDelta += get<0>(numBlocks[index])-1;
                     columnDelta += get<1>(numBlocks[index])-1;
-                    long long bproIndex = (numColors+numColors-c1+1)*c1/2*get<0>(numOffsets[index])*get<1>(numOffsets[index])+rowDelta*get<1>(numOffsets[index])+columnDelta;
-                    tuple<int,int> pos (rowDelta,columnDelta);
-                    if (newBproFeature && bproExistence[index][rowDelta][columnDelta]){
-                        changed[index].push_back(pos);
-                        bproExistence[index][rowDelta][columnDelta]=false;
-                        features.push_back(baseBpro[index]+bproIndex);
+                    long long offset = rowDelta*numColumnOffsets+columnDelta;
+                    if (newBproFeature && bproStamps.insert(bproStampBase[index]+offset)){
+                        pendingFeatures.push_back(make_pair(pendingKey(k->firstBlob,h->firstBlob,index,numResolutions),pairBase+offset));
                     }
-                    
-                    //add three point feature
-                    /*if (previousBlobs.size()>0){
-                        addThreePointOffsetsIndices(features,pos,*k,bproIndex);
-                    }*/
-
                 }
-                
             }
         }
-        resetBproExistence();
-        //resetThreePointExistence();
+        addPendingFeatures(features);
+        bproStamps.clear();
         
         for (int index2=index1+1;index2<blobActiveColors.size();++index2){
             int c2 = blobActiveColors[index2];
-            for (auto it1=blobs[c1].begin();it1!=blobs[c1].end();++it1){
-                for (auto it2=blobs[c2].begin();it2!=blobs[c2].end();++it2){
-                    
-                    for (int index=0;index<numResolutions;++index){
-                        int rowDelta = get<0>(*it1)/get<0>(resolutions[index])-get<0>(*it2)/get<0>(resolutions[index])+get<0>(numBlocks[index])-1;
-                        int columnDelta = get<1>(*it1)/get<1>(resolutions[index])-get<1>(*it2)/get<1>(resolutions[index])+get<1>(numBlocks[index])-1;
-                        long long bproIndex = (numColors+numColors-c1+1)*c1/2*get<0>(numOffsets[index])*get<1>(numOffsets[index])+(c2-c1)*get<0>(numOffsets[index])*get<1>(numOffsets[index])+rowDelta*get<1>(numOffsets[index])+columnDelta;
-                        tuple<int,int> pos(rowDelta,columnDelta);
-                        if (bproExistence[index][rowDelta][columnDelta]){
-                            changed[index].push_back(pos);
-                            bproExistence[index][rowDelta][columnDelta]=false;
-                            features.push_back(baseBpro[index]+bproIndex);
+            for (int index=0;index<numResolutions;++index){
+                int numColumnOffsets = get<1>(numOffsets[index]);
+                long long pairBase = baseBpro[index]+((long long)(numColors+numColors-c1+1)*c1/2+(c2-c1))*get<0>(numOffsets[index])*numColumnOffsets;
+                vector<Cell_Element>& cells1 = blobCells[index][c1];
+                vector<Cell_Element>& cells2 = blobCells[index][c2];
+                for (auto it1=cells1.begin();it1!=cells1.end();++it1){
+                    for (auto it2=cells2.begin();it2!=cells2.end();++it2){
+                        int rowDelta = it1->row-it2->row+get<0>(numBlocks[index])-1;
+                        int columnDelta = it1->column-it2->column+get<1>(numBlocks[index])-1;
+                        long long offset = rowDelta*numColumnOffsets+columnDelta;
+                        if (bproStamps.insert(bproStampBase[index]+offset)){
+                            pendingFeatures.push_back(make_pair(pendingKey(it1->firstBlob,it2->firstBlob,index,numResolutions),pairBase+offset));
                         }
-                        
-                        //add three point feature
-                        /*if (previousBlobs.size()>0){
-                            addThreePointOffsetsIndices(features,pos,*it1,bproIndex);
-                        }*/
-
-                        
                     }
                 }
             }
-            resetBproExistence();
-            //resetThreePointExistence();
+            addPendingFeatures(features);
+            bproStamps.clear();
         }
     }
 }
 
 void BlobTimeFeatures::getBasicFeatures(vector<long long>& features){
-    vector<bool> basicNotExistence(numBasicFeatures,true);
+    basicStamps.clear();
     for (unsigned short i=0;i<blobActiveColors.size();i++){
         int color = blobActiveColors[i];
         for (auto itt = blobs[color].begin();itt!=blobs[color].end();++itt){
@@ -307,9 +688,8 @@ void BlobTimeFeatures::getBasicFeatures(vector<long long>& features){
             int y = get<1>(*itt);
             for (int index=0;index<numResolutions;++index){
                 long long featureIndex = baseBasic[index]+x/get<0>(resolutions[index])*get<1>(numBlocks[index])+y/get<1>(resolutions[index]);
-                if (basicNotExistence[featureIndex]){
+                if (basicStamps.insert(featureIndex)){
                     features.push_back(featureIndex);
-                    basicNotExistence[featureIndex] = false;
                 }
             }
         }
@@ -322,26 +702,26 @@ void BlobTimeFeatures::addTimeDimensionalOffsets(vector<long long>& features){
         for (int index2=0;index2<blobActiveColors.size();++index2){
             int c2 = blobActiveColors[index2];
             
-            for (auto it1=previousBlobs[c1].begin();it1 !=previousBlobs[c1].end();++it1){
-                for (auto it2=blobs[c2].begin();it2 != blobs[c2].end();++it2){
-                    
-                    for (int index=0;index<numResolutions;++index){
-                        int rowDelta =get<0>(*it1)/get<0>(resolutions[index])-get<0>(*it2)/get<0>(resolutions[index])+get<0>(numBlocks[index])-1;
-                        int columnDelta = get<1>(*it1)/get<1>(resolutions[index])-get<1>(*it2)/get<1>(resolutions[index])+get<1>(numBlocks[index])-1;
-                        if (bproExistence[index][rowDelta][columnDelta]){
-                            tuple<int,int> pos(rowDelta,columnDelta);
-                            changed[index].push_back(pos);
-                            bproExistence[index][rowDelta][columnDelta]=false;
-                            features.push_back(baseTime[index]+c1*numColors*get<0>(numOffsets[index])*get<1>(numOffsets[index])+c2*get<0>(numOffsets[index])*get<1>(numOffsets[index])+rowDelta*get<1>(numOffsets[index])+columnDelta);
+            for (int index=0;index<numResolutions;++index){
+                int numColumnOffsets = get<1>(numOffsets[index]);
+                long long pairBase = baseTime[index]+((long long)c1*numColors+c2)*get<0>(numOffsets[index])*numColumnOffsets;
+                vector<Cell_Element>& cells1 = previousBlobCells[index][c1];
+                vector<Cell_Element>& cells2 = blobCells[index][c2];
+                for (auto it1=cells1.begin();it1!=cells1.end();++it1){
+                    for (auto it2=cells2.begin();it2!=cells2.end();++it2){
+                        int rowDelta = it1->row-it2->row+get<0>(numBlocks[index])-1;
+                        int columnDelta = it1->column-it2->column+get<1>(numBlocks[index])-1;
+                        long long offset = rowDelta*numColumnOffsets+columnDelta;
+                        if (bproStamps.insert(bproStampBase[index]+offset)){
+                            pendingFeatures.push_back(make_pair(pendingKey(it1->firstBlob,it2->firstBlob,index,numResolutions),pairBase+offset));
                         }
                     }
                 }
             }
-            resetBproExistence();
-           
+            addPendingFeatures(features);
+            bproStamps.clear();
         }
     }
-    
 }
 
 void BlobTimeFeatures::addThreePointOffsetsIndices(vector<long long>& features, tuple<int,int>& offset, tuple<int,int>& p1, long long& bproIndex){
@@ -363,11 +743,52 @@ void BlobTimeFeatures::addThreePointOffsetsIndices(vector<long long>& features,
 
 
 void BlobTimeFeatures::getActiveFeaturesIndices(const ALEScreen &screen, const ALERAM &ram, vector<long long>& features){
-    
-    blobs.clear();
-    blobs.resize(numColors);
+    getScreenFeatures(screen.getArray(), features);
+}
+
+void BlobTimeFeatures::getActiveFeaturesIndices(const pixel_t* screen, int screenIndex, vector<long long>& features){
+    if (screenIndex>=screenPreviousBlobs.size()){
+        screenPreviousBlobs.resize(screenIndex+1);
+        screenPreviousBlobActiveColors.resize(screenIndex+1);
+        screenPreviousBlobCells.resize(screenIndex+1);
+    }
+    //The blobs of the previous frame of this screen take the place of the ones of getActiveFeaturesIndices
+    previousBlobs.swap(screenPreviousBlobs[screenIndex]);
+    previousBlobActiveColors.swap(screenPreviousBlobActiveColors[screenIndex]);
+    previousBlobCells.swap(screenPreviousBlobCells[screenIndex]);
+    getScreenFeatures(screen, features);
+    previousBlobs.swap(screenPreviousBlobs[screenIndex]);
+    previousBlobActiveColors.swap(screenPreviousBlobActiveColors[screenIndex]);
+    previousBlobCells.swap(screenPreviousBlobCells[screenIndex]);
+}
+
+void BlobTimeFeatures::getActiveFeaturesIndicesBatch(const pixel_t* screens, const vector<int>& screenIndices, vector<vector<long long> >& features){
+    for (int k=0;k<screenIndices.size();++k){
+        int index = screenIndices[k];
+        if (features.size()<=index){
+            features.resize(index+1);
+        }
+        features[index].clear();
+        getActiveFeaturesIndices(screens+index*210*160, index, features[index]);
+    }
+}
+
+void BlobTimeFeatures::getScreenFeatures(const pixel_t* screen, vector<long long>& features){
+    //blobs has the blobs of the frame before the previous one, its vectors keep their capacity
+    for (int index=0;index<blobActiveColors.size();++index){
+        blobs[blobActiveColors[index]].clear();
+    }
     blobActiveColors.clear();
-    getBlobs(screen);
+    if (blobs.size()<numColors){
+        blobs.resize(numColors);
+    }
+    if (blobLabeler==1){
+        getBlobsFromRuns(screen);
+    }else if (blobLabeler==2){
+        getBlobsFromBitPlanes(screen);
+    }else{
+        getBlobs(screen);
+    }
     
     /*long long numBlobsForPrint = 0;
     for (auto it=blobs.begin();it!=blobs.end();++it){
@@ -375,13 +796,15 @@ void BlobTimeFeatures::getActiveFeaturesIndices(const ALEScreen &screen, const A
     }
     cout<<numBlobsForPrint<<endl;*/
     getBasicFeatures(features);
+    getBlobCells();
     addRelativeFeaturesIndices(features);
     if (previousBlobs.size()>0){
         addTimeDimensionalOffsets(features);
     }
     features.push_back(numBasicFeatures+numRelativeFeatures + numTimeDimensionalOffsets);
-    previousBlobs = blobs;
-    previousBlobActiveColors = blobActiveColors;
+    previousBlobs.swap(blobs);
+    previousBlobActiveColors.swap(blobActiveColors);
+    previousBlobCells.swap(blobCells);
 }
 
 
@@ -389,15 +812,6 @@ long long BlobTimeFeatures::getNumberOfFeatures(){
     return numBasicFeatures+numRelativeFeatures + numTimeDimensionalOffsets+1;
 }
 
-void BlobTimeFeatures::resetBproExistence(){
-    for (int index = 0; index<numResolutions;++index){
-        for (vector<tuple<int,int> >::iterator it = changed[index].begin();it!=changed[index].end();++it){
-            bproExistence[index][get<0>(*it)][get<1>(*it)]=true;
-        }
-        changed[index].clear();
-    }
-}
-
 void BlobTimeFeatures::resetThreePointExistence(){
     for (int index = 0; index<numResolutions;++index){
         threePointExistence[index].clear();
@@ -421,7 +835,19 @@ void BlobTimeFeatures::updateRepresentatiePixel(int& x, int& y, Disjoint_Set_Ele
     root->size += other->size;
 }
 
+//The vectors of the blobs are emptied but kept, with their capacity, for the next frames
 void BlobTimeFeatures::clearCash(){
-    previousBlobs.clear();
+    for (int index=0;index<previousBlobActiveColors.size();++index){
+        previousBlobs[previousBlobActiveColors[index]].clear();
+    }
     previousBlobActiveColors.clear();
 }
+
+void BlobTimeFeatures::clearCash(int screenIndex){
+    if (screenIndex<screenPreviousBlobs.size()){
+        for (int index=0;index<screenPreviousBlobActiveColors[screenIndex].size();++index){
+            screenPreviousBlobs[screenIndex][screenPreviousBlobActiveColors[screenIndex][index]].clear();
+        }
+        screenPreviousBlobActiveColors[screenIndex].clear();
+    }
+}
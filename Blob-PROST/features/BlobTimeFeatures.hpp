@@ -17,9 +17,23 @@
 #include "Background.hpp"
 #endif
 
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+#include "../common/ScratchArena.hpp"
+#endif
+#ifndef STAMP_TABLE_H
+#define STAMP_TABLE_H
+#include "../common/StampTable.hpp"
+#endif
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+#include "../common/WorkerPool.hpp"
+#endif
+
 #include <tuple>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 //#include <sparsehash/unordered_map>
 //using google::unordered_map;
 
@@ -30,8 +44,22 @@ struct Disjoint_Set_Element{
     int color;
 };
 
+struct Run_Element{
+    int columnLeft, columnRight;
+    int color;
+};
+
+//A tile of a resolution with blobs of a color, firstBlob is the index of the first of them in the blobs of the color
+struct Cell_Element{
+    int row, column;
+    int firstBlob;
+};
+
 using namespace std;
 
+//Roots of the blobs of a color found by getBlobs, its nodes are in a ScratchArena
+typedef unordered_set<int, hash<int>, equal_to<int>, ArenaAllocator<int> > BlobIndexSet;
+
 class BlobTimeFeatures : public Features::Features{
 	private:
 		Parameters *param;
@@ -49,26 +77,95 @@ class BlobTimeFeatures : public Features::Features{
         vector<vector<tuple<int,int> > > previousBlobs;
         vector<int> blobActiveColors;
         vector<int> previousBlobActiveColors;
+        //Tiles of the blobs of each resolution and color, without repetitions: the pairs of blobs
+        //in the same tiles give the same offsets, so the offsets are found from the pairs of tiles
+        vector<vector<vector<Cell_Element> > > blobCells;
+        vector<vector<vector<Cell_Element> > > previousBlobCells;
+        //previousBlobs, previousBlobActiveColors and previousBlobCells of each screen of the batch API
+        vector<vector<vector<tuple<int,int> > > > screenPreviousBlobs;
+        vector<vector<int> > screenPreviousBlobActiveColors;
+        vector<vector<vector<vector<Cell_Element> > > > screenPreviousBlobCells;
     
         vector<tuple<int,int> > resolutions;
         vector<tuple<int,int> > numBlocks;
         vector<tuple<int,int> > numOffsets;
     
-        vector<vector<vector<bool> > > bproExistence;
-        vector<vector<tuple<int,int> > > changed;
+        StampTable bproStamps;              //offsets added for the current pair of colors, of all resolutions
+        vector<long long> bproStampBase;    //first entry of bproStamps of each resolution
+        vector<StampTable> cellStamps;      //tiles of each resolution already in the list of the current color
+        vector<int> numCellColumns;         //tiles per row of each resolution, counting a partial one
+        //Features of the current pair of colors, after the position the pair of blobs that first gives
+        //them and their resolution would put them in, see addPendingFeatures
+        vector<pair<long long,long long> > pendingFeatures;
     
         vector<unordered_map<long long,int> > threePointExistence;
     
         vector<long long> baseBpro, baseTime, baseBasic, baseThreePoint;
     
         int neighborSize;
+        int blobLabeler;
+    
+        vector<Run_Element> runs;
+        vector<Disjoint_Set_Element> runBlobs;
+        vector<int> rowRunStart;
+        //getBlobsFromRuns labels horizontal strips of the screen on their own, each one on a thread of
+        //labelingPool (NULL with a single strip). The runs of a strip starting at row x are stored from
+        //runs[x*160], so run indices keep the raster order.
+        vector<int> rowRunEnd;
+        vector<int> stripFirstRow;          //first row of each strip, and 210 after the last strip
+        vector<int> stripRunEnd;            //end of the runs of each strip
+        WorkerPool* labelingPool;
+        std::function<void(int)> labelStripTask;
+        const pixel_t* labelingScreen;
+        //Bit planes of getBlobsFromBitPlanes, 210 rows of PLANE_ROW_WORDS words each, column y is bit y%64 of word y/64
+        vector<unsigned long long> colorPlanes;     //pixels of each color in the frame, zero between frames
+        vector<unsigned long long> dilatedPlane;    //pixels of the current color dilated by neighborSize
+        vector<unsigned long long> planeColors;     //one bit per color present in the frame
+        vector<int> planeRowUp, planeRowDown;       //first and last row of each color present in the frame
+    
+        //Scratch memory of getBlobs and getBasicFeatures, kept between frames so that once it has
+        //grown to what a frame needs, extracting the features does not allocate
+        vector<int> screenPixels;
+        vector<Disjoint_Set_Element> disjoint_set;
+        vector<int> route;
+        ScratchArena blobIndexArena;
+        vector<BlobIndexSet> blobIndices;
+        StampTable basicStamps;             //basic features added for the current frame
     
-    void getBlobs(const ALEScreen &screen);
+    void getBlobs(const pixel_t* screen);
+    void getBlobsFromRuns(const pixel_t* screen);
+    /**
+     * Runs of a strip of labelingScreen, merged with the ones at most neighborSize away in the strip.
+     */
+    void labelStrip(int strip);
+    /**
+     * Merges the runs of row with the ones of the same color of otherRow, a previous row at most
+     * neighborSize rows away, whose column intervals are at most neighborSize columns apart.
+     */
+    void mergeRowRuns(int row, int otherRow);
+    void getBlobsFromBitPlanes(const pixel_t* screen);
+    void dilatePlane(const unsigned long long* plane, int firstRow, int lastRow);
+    /**
+     * Features of a screen given as 210x160 pixels, row by row, using and then replacing the blobs
+     * of the previous frame.
+     */
+    void getScreenFeatures(const pixel_t* screen, vector<long long>& features);
+    int findRunRoot(int index);
+    void mergeRuns(int first, int second);
     void getBasicFeatures(vector<long long>& features);
+    /**
+     * Fills blobCells with the tiles of the blobs of the active colors, in the order of their first blob.
+     */
+    void getBlobCells();
+    /**
+     * Adds the features in pendingFeatures to features, in the order the pairs of blobs give them and,
+     * for the same pair, of the resolutions. It is the order they had when the offsets were computed
+     * for every pair of blobs and every resolution.
+     */
+    void addPendingFeatures(vector<long long>& features);
     void addRelativeFeaturesIndices(vector<long long>& features);
     void addTimeDimensionalOffsets(vector<long long>& features);
     void addThreePointOffsetsIndices(vector<long long>& features, tuple<int,int>& offset, tuple<int,int>& p1, long long& bproIndex);
-    void resetBproExistence();
     void resetThreePointExistence();
     void updateRepresentatiePixel(int& x, int& y, Disjoint_Set_Element* root, Disjoint_Set_Element* other);
     int getPowerTwoOffset(int rawDelta);
@@ -115,5 +212,22 @@ class BlobTimeFeatures : public Features::Features{
  		* @return int number of features generated by this method.
  		*/
 		long long getNumberOfFeatures();
+        /**
+         * Batch API, used with NUM_ENVS > 1: the features of several screens are extracted with the same
+         * scratch memory (the labeling and the existence tables), only the blobs of the previous frame are
+         * kept for each screen. Screen k has the features getActiveFeaturesIndices would give if it was the
+         * only screen of a BlobTimeFeatures object.
+         *
+         * @param pixel_t* screen 210x160 pixels, row by row, as in ALEScreen
+         * @param int screenIndex index of the screen, whose previous frame is used
+         */
+        void getActiveFeaturesIndices(const pixel_t* screen, int screenIndex, vector<long long>& features);
+        /**
+         * @param pixel_t* screens screens one after the other, screen k has index k
+         * @param vector<int>& screenIndices the screens whose features are extracted, in this order
+         * @param vector<vector<long long> >& features features[k] receives the features of screen k
+         */
+        void getActiveFeaturesIndicesBatch(const pixel_t* screens, const vector<int>& screenIndices, vector<vector<long long> >& features);
         void clearCash();
+        void clearCash(int screenIndex);
 };
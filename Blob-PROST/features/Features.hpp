@@ -79,4 +79,24 @@ class Features{
 		*/
 		virtual ~Features();
         virtual void clearCash() = 0 ;
+        /**
+         * Batch API, used with NUM_ENVS > 1 to extract the features of the screens of several emulators
+         * with one object. Each screen has an index, and the features of a screen only depend on the
+         * previous frames of the same index.
+         *
+         * @param pixel_t* screen the screen as in ALEScreen::getArray()
+         * @param int screenIndex index of the screen
+         */
+        virtual void getActiveFeaturesIndices(const pixel_t* screen, int screenIndex, vector<long long>& features) = 0;
+        /**
+         * @param pixel_t* screens screens one after the other, the k-th has index k
+         * @param vector<int>& screenIndices the screens whose features are extracted
+         * @param vector<vector<long long> >& features features[k] receives the features of screen k,
+         *        for each k in screenIndices
+         */
+        virtual void getActiveFeaturesIndicesBatch(const pixel_t* screens, const vector<int>& screenIndices, vector<vector<long long> >& features) = 0;
+        /**
+         * Same as clearCash, only for the screen with the given index of the batch API.
+         */
+        virtual void clearCash(int screenIndex) = 0;
 };
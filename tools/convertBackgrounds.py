@@ -0,0 +1,31 @@
+# Converts the comma-separated backgrounds (game.bg) to the packed binary format read by
+# Background (game.bgb). Background never writes them: without an up-to-date binary file it
+# parses the text file, so run this script again after changing a background.
+#
+# Usage: python convertBackgrounds.py <folder with the .bg files>
+import os
+import struct
+import sys
+
+def convertBackground(textPath):
+	with open(textPath) as f:
+		lines = [line.strip() for line in f if line.strip()]
+	width, height = [int(v) for v in lines[0].split(',')]
+	pixels = bytearray(width * height)
+	for row, line in enumerate(lines[1:height + 1]):
+		for col, value in enumerate(line.split(',')):
+			pixels[row * width + col] = int(value)
+
+	binaryPath = textPath + 'b'
+	temporaryPath = binaryPath + '.tmp%d' % os.getpid()
+	with open(temporaryPath, 'wb') as f:
+		f.write(b'BGB2')
+		f.write(struct.pack('<ii', width, height))
+		f.write(pixels)
+	os.rename(temporaryPath, binaryPath)
+
+folder = sys.argv[1]
+for fileName in sorted(os.listdir(folder)):
+	if fileName.endswith('.bg'):
+		convertBackground(os.path.join(folder, fileName))
+		print(fileName + 'b')